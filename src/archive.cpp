@@ -0,0 +1,113 @@
+#include "archive.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr char magic[4] = {'S', 'N', 'K', 'A'};
+static constexpr std::uint8_t version = 1;
+
+static constexpr std::size_t header_len = 16;
+static constexpr std::size_t entry_len = 16;
+
+bool write_archive(const char *path, const std::vector<std::vector<std::uint8_t>> &replays) {
+  std::vector<std::uint8_t> index;
+  index.reserve(header_len + entry_len * replays.size());
+
+  for (auto c : magic) {
+    put_u8(index, std::uint8_t(c));
+  }
+  put_u8(index, version);
+  index.insert(index.end(), 3, 0);
+  put_u64(index, replays.size());
+
+  auto offset = std::uint64_t(header_len + entry_len * replays.size());
+  for (auto &replay : replays) {
+    put_u64(index, offset);
+    put_u64(index, replay.size());
+    offset += replay.size();
+  }
+
+  auto file = std::fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  auto ok = std::fwrite(index.data(), 1, index.size(), file) == index.size();
+  for (auto &replay : replays) {
+    ok = ok && std::fwrite(replay.data(), 1, replay.size(), file) == replay.size();
+  }
+
+  return std::fclose(file) == 0 && ok;
+}
+
+MappedFile::MappedFile(const char *path) {
+  auto fd = ::open(path, O_RDONLY);
+  if (fd < 0)
+    throw FormatError(std::string("cannot open ") + path);
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    throw FormatError(std::string("cannot read ") + path);
+  }
+
+  len = std::size_t(info.st_size);
+
+  // mmap refuses empty mappings; an empty view fails to parse as usual.
+  if (len > 0) {
+    auto mapped = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      ::close(fd);
+      throw FormatError(std::string("cannot map ") + path);
+    }
+
+    // Archives are read front to back, so let the kernel read ahead. Advice
+    // values are not flags, so each takes a call of its own.
+    ::madvise(mapped, len, MADV_SEQUENTIAL);
+    ::madvise(mapped, len, MADV_WILLNEED);
+    data = static_cast<const std::uint8_t *>(mapped);
+  }
+
+  // The mapping holds its own reference to the file.
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) {
+    ::munmap(const_cast<std::uint8_t *>(data), len);
+  }
+}
+
+ReplayArchive::ReplayArchive(Span<std::uint8_t> bytes) : bytes(bytes) {
+  ByteReader reader(bytes.items, bytes.size());
+
+  if (std::memcmp(reader.skip(sizeof(magic)), magic, sizeof(magic)) != 0)
+    throw FormatError("not a replay archive");
+  if (reader.u8() != version)
+    throw FormatError("unsupported replay archive version");
+
+  reader.skip(3);
+
+  auto games = reader.u64();
+  if (games > reader.remaining() / entry_len)
+    throw FormatError("replay archive index out of range");
+
+  count = std::size_t(games);
+  index = reader.skip(entry_len * count);
+}
+
+Span<std::uint8_t> ReplayArchive::game(std::size_t nth) const {
+  auto offset = load_u64(index + entry_len * nth);
+  auto len = load_u64(index + entry_len * nth + 8);
+
+  if (offset > bytes.size() || len > bytes.size() - offset)
+    throw FormatError("replay archive entry out of range");
+
+  return Span<std::uint8_t>{bytes.items + offset, std::size_t(len)};
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+// Many replays in one file, for tools that go through games by the million.
+// An index of fixed-width entries at the front finds any game in O(1), and
+// the reader maps the file and parses games in place, so going through an
+// archive costs no reads and no allocations per game.
+//
+// Layout, little-endian:
+//   "SNKA" u8:version u8[3]:reserved u64:count
+//   {u64:offset u64:len}[count], offsets from the start of the file
+//   the replays themselves, in the format replay.hpp describes
+
+#include "replay.hpp"
+#include "storage.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Writes `replays`, each one serialised by ReplayWriter, as an archive.
+bool write_archive(const char *path, const std::vector<std::vector<std::uint8_t>> &replays);
+
+// A read-only view of a whole file through mmap.
+class MappedFile {
+  const std::uint8_t *data = nullptr;
+  std::size_t len = 0;
+
+public:
+  // Throws FormatError if the file cannot be opened or mapped.
+  explicit MappedFile(const char *path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  Span<std::uint8_t> bytes() const noexcept { return {data, len}; }
+};
+
+// An archive's index over bytes that have to outlive it.
+class ReplayArchive {
+  Span<std::uint8_t> bytes;
+  const std::uint8_t *index = nullptr;
+  std::size_t count = 0;
+
+public:
+  // Throws FormatError if `bytes` are not an archive.
+  explicit ReplayArchive(Span<std::uint8_t> bytes);
+
+  std::size_t size() const noexcept { return count; }
+
+  // The bytes of game `nth`, to parse with Replay. Throws FormatError if its
+  // index entry points outside the archive.
+  Span<std::uint8_t> game(std::size_t nth) const;
+};
+
+// Plays every game in `archive` to its end on `threads` threads (0 for one per
+// core), then calls `visit(nth, replay, sim)` on the thread that played it.
+// Games are handed out in batches from a shared counter, and each thread
+// reuses one ReplayPlayer for all of its games. The first FormatError thrown
+// on any thread stops the rest and is rethrown here.
+template <typename Visit>
+void resimulate(const ReplayArchive &archive, Visit &&visit, unsigned threads = 0) {
+  static constexpr std::size_t batch = 64;
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::exception_ptr> errors(threads);
+
+  auto work = [&](unsigned worker) {
+    try {
+      std::optional<ReplayPlayer> player;
+
+      while (!failed.load(std::memory_order_relaxed)) {
+        auto first = next.fetch_add(batch, std::memory_order_relaxed);
+        if (first >= archive.size()) {
+          break;
+        }
+
+        for (auto nth = first; nth < std::min(first + batch, archive.size()); nth++) {
+          Replay replay(archive.game(nth));
+
+          if (player) {
+            player->start(replay);
+          } else {
+            player.emplace(replay);
+          }
+
+          while (!player->finished()) {
+            player->step();
+          }
+
+          const auto &played = *player;
+          visit(nth, static_cast<const Replay &>(replay), played.sim());
+        }
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+      failed.store(true, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned worker = 1; worker < threads; worker++) {
+    workers.emplace_back(work, worker);
+  }
+
+  work(0);
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
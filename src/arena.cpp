@@ -0,0 +1,367 @@
+// Plays controllers against the same seeds headless and writes how every
+// game went, so controllers are compared by the thousand games rather than
+// by watching them.
+//
+//   snek-arena [--autopilot] [--policy PATH]... [--seeds K] [--seed BASE]
+//              [--size WxH] [--spawn-interval TICKS] [--max-ticks N]
+//              [--threads N] [--format csv|binary] [--out PATH]
+//
+// Every controller plays seeds BASE to BASE + K - 1. A game ends when the
+// snake dies or fills the board, after --max-ticks, or when the controller
+// leaves the snake without a direction to start in. Rows are written as games finish, so
+// their order depends on the threads, but each names its controller and seed.
+//
+// CSV has a header row, then controller,seed,score,length,ticks,death with
+// death one of none, wall, self, idle or full. Binary is, little-endian,
+//   "SNKT" u8:version u8[3]:reserved u32:controllers
+//   {varint:len u8[len]:name}[controllers]
+//   {u32:controller u64:seed u32:score u32:length u32:ticks u8:Ending}...
+// a record per game until the end of the file.
+
+#include "autopilot.hpp"
+#include "bytes.hpp"
+#include "plugin.hpp"
+#include "sim.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class Format : std::uint8_t {
+  Csv,
+  Binary,
+};
+
+struct Options {
+  bool autopilot = false;
+  std::vector<const char *> policies;
+  std::uint64_t seeds = 100, seed = 0;
+  std::size_t horizontal = 19, vertical = 15;
+  std::uint32_t spawn_interval = spawn_ticks;
+  std::uint32_t max_ticks = 100000;
+  std::size_t threads = 0;
+  Format format = Format::Csv;
+  const char *out = nullptr;
+};
+
+static constexpr std::uint8_t binary_magic[4] = {'S', 'N', 'K', 'T'};
+static constexpr std::uint8_t binary_version = 2;
+
+// How a game ended. Deaths keep their MoveResult values.
+enum class Ending : std::uint8_t {
+  // Out of ticks.
+  None = 0,
+  Wall = std::uint8_t(MoveResult::HitWall),
+  Self = std::uint8_t(MoveResult::HitSelf),
+  // The snake had no direction to start in, so it never moved.
+  Idle,
+  // The snake covers the whole board, which is winning.
+  Full,
+};
+
+struct GameResult {
+  std::uint32_t controller;
+  std::uint64_t seed;
+  std::uint32_t score, length, ticks;
+  Ending death;
+};
+
+static void usage(char const *name) {
+  std::cerr << "usage: " << name << " [--autopilot] [--policy PATH]... [--seeds K]\n"
+            << "       [--seed BASE] [--size WxH] [--spawn-interval TICKS] [--max-ticks N]\n"
+            << "       [--threads N] [--format csv|binary] [--out PATH]\n"
+            << "with no controller given, plays the autopilot\n";
+}
+
+static bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    auto arg = argv[i];
+    auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+    if (std::strcmp(arg, "--autopilot") == 0) {
+      options.autopilot = true;
+      continue;
+    }
+
+    if (value == nullptr) {
+      return false;
+    }
+
+    if (std::strcmp(arg, "--policy") == 0) {
+      options.policies.push_back(value);
+    } else if (std::strcmp(arg, "--seeds") == 0) {
+      options.seeds = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options.seed = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--size") == 0) {
+      char *end = nullptr;
+      options.horizontal = std::strtoul(value, &end, 10);
+      if (*end != 'x') {
+        return false;
+      }
+
+      options.vertical = std::strtoul(end + 1, &end, 10);
+      if (*end != '\0' || options.horizontal == 0 || options.vertical == 0) {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--spawn-interval") == 0) {
+      options.spawn_interval = std::uint32_t(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--max-ticks") == 0) {
+      options.max_ticks = std::uint32_t(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--threads") == 0) {
+      options.threads = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--out") == 0) {
+      options.out = value;
+    } else if (std::strcmp(arg, "--format") == 0) {
+      if (std::strcmp(value, "csv") == 0) {
+        options.format = Format::Csv;
+      } else if (std::strcmp(value, "binary") == 0) {
+        options.format = Format::Binary;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+
+    i++;
+  }
+
+  return true;
+}
+
+static const char *death_name(Ending ending) {
+  switch (ending) {
+  case Ending::Wall:
+    return "wall";
+  case Ending::Self:
+    return "self";
+  case Ending::Idle:
+    return "idle";
+  case Ending::Full:
+    return "full";
+  default:
+    return "none";
+  }
+}
+
+// Writes results as they come in from any thread.
+class ResultWriter {
+  std::FILE *file;
+  Format format;
+  std::mutex mutex;
+  std::vector<std::uint8_t> record;
+  bool failed = false;
+
+public:
+  ResultWriter(std::FILE *file, Format format, const std::vector<std::string> &names)
+    : file(file), format(format) {
+    if (format == Format::Csv) {
+      std::fputs("controller,seed,score,length,ticks,death\n", file);
+      return;
+    }
+
+    std::vector<std::uint8_t> header(binary_magic, binary_magic + sizeof(binary_magic));
+    put_u8(header, binary_version);
+    header.insert(header.end(), 3, 0);
+    put_u32(header, std::uint32_t(names.size()));
+
+    for (auto &name : names) {
+      put_varint(header, name.size());
+      header.insert(header.end(), name.begin(), name.end());
+    }
+
+    failed = std::fwrite(header.data(), 1, header.size(), file) != header.size();
+  }
+
+  void write(const GameResult &result, const std::string &name) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (format == Format::Csv) {
+      failed |= std::fprintf(file, "%s,%llu,%u,%u,%u,%s\n", name.c_str(),
+                             static_cast<unsigned long long>(result.seed), result.score,
+                             result.length, result.ticks, death_name(result.death)) < 0;
+      return;
+    }
+
+    record.clear();
+    put_u32(record, result.controller);
+    put_u64(record, result.seed);
+    put_u32(record, result.score);
+    put_u32(record, result.length);
+    put_u32(record, result.ticks);
+    put_u8(record, std::uint8_t(result.death));
+
+    failed |= std::fwrite(record.data(), 1, record.size(), file) != record.size();
+  }
+
+  bool ok() const noexcept { return !failed; }
+};
+
+// One game of `steer` from `seed`, on `sim` started over for it.
+template <typename Steer>
+static GameResult play(SnakeSim &sim, const Options &options, std::uint64_t seed, Steer &&steer) {
+  sim.restart(seed, options.spawn_interval);
+
+  auto ending = Ending::None;
+  std::uint32_t eaten = 0;
+
+  for (;;) {
+    // Nothing is left to eat, and any move runs into the snake.
+    if (sim.snake().len() == sim.board().len()) {
+      ending = Ending::Full;
+      break;
+    }
+
+    if (sim.ticks() >= options.max_ticks) {
+      break;
+    }
+
+    auto direct = steer(sim);
+    if (direct != Direction::None) {
+      sim.try_set_direction(direct);
+    }
+
+    // A tick would run a snake heading nowhere into itself.
+    if (sim.direction() == Direction::None) {
+      ending = Ending::Idle;
+      break;
+    }
+
+    auto result = sim.try_tick();
+    if (is_fatal(result)) {
+      ending = Ending(result);
+      break;
+    }
+
+    eaten += result == MoveResult::Ate;
+  }
+
+  return GameResult{0, seed, eaten, std::uint32_t(sim.snake().len()), sim.ticks(), ending};
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  if (!options.autopilot && options.policies.empty()) {
+    options.autopilot = true;
+  }
+
+  // Controller 0 is the autopilot when it plays; the policies follow.
+  std::vector<std::unique_ptr<PolicyPlugin>> plugins;
+  std::vector<std::string> names;
+
+  if (options.autopilot) {
+    names.push_back("autopilot");
+  }
+
+  for (auto path : options.policies) {
+    try {
+      plugins.push_back(std::make_unique<PolicyPlugin>(path));
+    } catch (std::runtime_error const &ex) {
+      std::cerr << ex.what() << "\n";
+      return 1;
+    }
+
+    names.push_back(plugins.back()->name());
+  }
+
+  auto file = stdout;
+  if (options.out != nullptr) {
+    file = std::fopen(options.out, options.format == Format::Binary ? "wb" : "w");
+    if (file == nullptr) {
+      std::cerr << "could not open " << options.out << "\n";
+      return 1;
+    }
+  }
+
+  ResultWriter writer(file, options.format, names);
+
+  auto threads = options.threads != 0 ? options.threads
+                                      : std::max(1u, std::thread::hardware_concurrency());
+  auto games = names.size() * options.seeds;
+
+  // Games are handed out one at a time, every controller's in turn, so a
+  // slow controller is spread over all the threads rather than holding one.
+  std::atomic<std::uint64_t> next{0};
+  std::vector<std::atomic<std::uint64_t>> scores(names.size());
+  std::atomic<bool> failed{false};
+
+  auto work = [&] {
+    SnakeSim sim(options.horizontal, options.vertical, 0, options.spawn_interval);
+
+    for (std::uint64_t game; (game = next.fetch_add(1, std::memory_order_relaxed)) < games;) {
+      auto controller = std::uint32_t(game % names.size());
+      auto seed = options.seed + game / names.size();
+
+      GameResult result;
+      try {
+        if (options.autopilot && controller == 0) {
+          // A fresh autopilot each game, so what it remembers of the last
+          // cannot make results depend on which thread played what.
+          Autopilot pilot(sim.board());
+          result = play(sim, options, seed,
+                        [&](const SnakeSim &current) { return pilot.steer(current); });
+        } else {
+          auto &plugin = *plugins[controller - (options.autopilot ? 1 : 0)];
+          PolicyPlugin::Game policy(plugin, options.horizontal, options.vertical, seed);
+          result = play(sim, options, seed,
+                        [&](const SnakeSim &current) { return policy.steer(current); });
+        }
+      } catch (std::runtime_error const &ex) {
+        std::cerr << ex.what() << "\n";
+        failed = true;
+        continue;
+      }
+
+      result.controller = controller;
+      scores[controller].fetch_add(result.score, std::memory_order_relaxed);
+      writer.write(result, names[controller]);
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (std::size_t i = 1; i < threads; i++) {
+    workers.emplace_back(work);
+  }
+
+  work();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::fflush(file);
+  if (!writer.ok() || std::ferror(file) != 0 || (file != stdout && std::fclose(file) != 0)) {
+    std::cerr << "could not write the results\n";
+    return 1;
+  }
+
+  for (std::size_t i = 0; i < names.size(); i++) {
+    std::cerr << names[i] << ": mean score "
+              << double(scores[i].load()) / double(std::max<std::uint64_t>(1, options.seeds))
+              << "\n";
+  }
+
+  std::cerr << games << " games in " << seconds << " s on " << threads << " threads\n";
+
+  return failed ? 1 : 0;
+}
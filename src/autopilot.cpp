@@ -0,0 +1,354 @@
+#include "autopilot.hpp"
+
+#include <algorithm>
+#include <utility>
+
+static constexpr Direction directions[] = {Direction::Left, Direction::Right, Direction::Up,
+                                           Direction::Down};
+
+// A shortcut must leave this many free blocks ahead of the tail, so the
+// snake can grow while it catches up without running into itself.
+static constexpr std::size_t shortcut_slack = 4;
+
+Autopilot::Autopilot(const Board &board, std::size_t max_depth)
+  : horizontal(board.horizontal()), vertical(board.vertical()),
+    place(board.len(), npos), max_depth(max_depth), word_len(board.snake_bits().word_len()),
+    not_first_column(word_len), not_last_column(word_len), open(word_len), reached(word_len) {
+  for (std::size_t i = 0; i < board.len(); i++) {
+    auto bit = std::uint64_t(1) << (i % 64);
+
+    open[i / 64] |= bit;
+    if (i % horizontal != 0) {
+      not_first_column[i / 64] |= bit;
+    }
+
+    if (i % horizontal != horizontal - 1) {
+      not_last_column[i / 64] |= bit;
+    }
+  }
+
+  for (int k = 0; k < 4; k++) {
+    frontiers[k].assign(word_len, 0);
+    grown[k].assign(word_len, 0);
+  }
+
+  build_cycle();
+}
+
+// Boards with an even number of rows go right and left along every row but
+// the first column, then back up that column. An even number of columns
+// is the same turned on its side. With both odd, the last row is taken in
+// pairs of blocks as detours from the row above, all but its last block.
+void Autopilot::build_cycle() {
+  auto w = horizontal, h = vertical;
+  bool transposed = false;
+
+  if (h % 2 != 0 && w % 2 == 0) {
+    std::swap(w, h);
+    transposed = true;
+  }
+
+  if (w < 2 || h < 2 || (h % 2 != 0 && (w < 3 || h < 3))) {
+    return;
+  }
+
+  auto visit = [&](std::size_t x, std::size_t y) {
+    if (transposed) {
+      std::swap(x, y);
+    }
+
+    place[x + y * horizontal] = std::uint32_t(cycle.size());
+    cycle.push_back(std::uint32_t(x + y * horizontal));
+  };
+
+  auto rows = h % 2 == 0 ? h : h - 1;
+
+  visit(0, 0);
+  for (std::size_t y = 0; y < rows; y++) {
+    if (y % 2 == 0) {
+      for (std::size_t x = 1; x < w; x++) {
+        visit(x, y);
+      }
+    } else if (y + 1 < rows || rows == h) {
+      for (std::size_t x = w - 1; x >= 1; x--) {
+        visit(x, y);
+      }
+    } else {
+      visit(w - 1, y);
+
+      for (std::size_t x = w - 2; x < w; x -= 2) {
+        visit(x, y);
+        visit(x, y + 1);
+        visit(x - 1, y + 1);
+        visit(x - 1, y);
+      }
+    }
+  }
+
+  for (std::size_t y = rows == h ? h - 1 : h - 3; y >= 1 && y < h; y--) {
+    visit(0, y);
+  }
+}
+
+bool Autopilot::in_cycle_order(const Snake &snake) const noexcept {
+  std::size_t around = 0;
+
+  for (std::size_t i = snake.len(); i-- > 0;) {
+    auto at = place[snake[i].x + snake[i].y * horizontal];
+    if (at == npos) {
+      return false;
+    }
+
+    if (i > 0) {
+      auto ahead = place[snake[i - 1].x + snake[i - 1].y * horizontal];
+      if (ahead == npos || ahead == at) {
+        return false;
+      }
+
+      around += distance(at, ahead);
+    }
+  }
+
+  return around < cycle.size();
+}
+
+int Autopilot::search(const Board &board, const Position *starts, int count) {
+  auto snake = board.snake_bits().words();
+  auto fruit = board.fruit_bits().words();
+
+  auto at = [&](const std::vector<std::uint64_t> &plane, std::size_t word, std::ptrdiff_t by) {
+    auto other = std::ptrdiff_t(word) + by;
+    return other >= 0 && other < std::ptrdiff_t(word_len) ? plane[std::size_t(other)] : 0;
+  };
+
+  auto row_shift = std::ptrdiff_t(horizontal / 64);
+  auto bit_shift = unsigned(horizontal % 64);
+
+  // The blocks next to any in `plane`, for one word.
+  auto adjacent = [&](const std::vector<std::uint64_t> &plane, std::size_t word) {
+    auto here = plane[word];
+    auto right = (here >> 1) | (at(plane, word, 1) << 63);
+    auto left = (here << 1) | (at(plane, word, -1) >> 63);
+
+    auto below = at(plane, word, row_shift) >> bit_shift;
+    auto above = at(plane, word, -row_shift) << bit_shift;
+    if (bit_shift != 0) {
+      below |= at(plane, word, row_shift + 1) << (64 - bit_shift);
+      above |= at(plane, word, -row_shift - 1) >> (64 - bit_shift);
+    }
+
+    return (right & not_last_column[word]) | (left & not_first_column[word]) | below | above;
+  };
+
+  // The box of rows and columns the search has reached, which grows by at
+  // most a block each way a step.
+  auto top = vertical, bottom = std::size_t(0);
+  auto left = horizontal, right = std::size_t(0);
+
+  for (int k = 0; k < count; k++) {
+    if (board.is_fruit(starts[k])) {
+      return k;
+    }
+  }
+
+  for (int k = 0; k < count; k++) {
+    auto index = board.index(starts[k]);
+
+    frontiers[k][index / 64] |= std::uint64_t(1) << (index % 64);
+    reached[index / 64] |= std::uint64_t(1) << (index % 64);
+
+    top = std::min<std::size_t>(top, starts[k].y);
+    bottom = std::max<std::size_t>(bottom, starts[k].y);
+    left = std::min<std::size_t>(left, starts[k].x);
+    right = std::max<std::size_t>(right, starts[k].x);
+  }
+
+  // Runs `each` on every word holding part of the box once, in order.
+  auto for_box = [&](auto &&each) {
+    std::size_t done = 0;
+
+    for (auto y = top; y <= bottom; y++) {
+      auto first = std::max(done, (y * horizontal + left) / 64);
+      auto last = (y * horizontal + right) / 64 + 1;
+
+      for (auto word = first; word < last; word++) {
+        each(word);
+      }
+
+      done = std::max(done, last);
+    }
+  };
+
+  int found = -1;
+
+  for (std::size_t depth = 1; depth < max_depth && found < 0; depth++) {
+    top = top > 0 ? top - 1 : 0;
+    bottom = std::min(bottom + 1, vertical - 1);
+    left = left > 0 ? left - 1 : 0;
+    right = std::min(right + 1, horizontal - 1);
+
+    bool any = false;
+
+    for_box([&](std::size_t word) {
+      auto unclaimed = open[word] & ~snake[word] & ~reached[word];
+
+      // A block reached by two first steps at once goes to the earlier one.
+      for (int k = 0; k < count; k++) {
+        auto next = adjacent(frontiers[k], word) & unclaimed;
+        unclaimed &= ~next;
+        grown[k][word] = next;
+
+        if (next != 0) {
+          any = true;
+
+          if (found < 0 && (next & fruit[word]) != 0) {
+            found = k;
+          }
+        }
+      }
+
+      reached[word] = open[word] & ~snake[word] & ~unclaimed;
+    });
+
+    for (int k = 0; k < count; k++) {
+      std::swap(frontiers[k], grown[k]);
+    }
+
+    if (!any) {
+      break;
+    }
+  }
+
+  // Nothing outside the box was touched.
+  for_box([&](std::size_t word) {
+    reached[word] = 0;
+
+    for (int k = 0; k < count; k++) {
+      frontiers[k][word] = 0;
+      grown[k][word] = 0;
+    }
+  });
+
+  return found;
+}
+
+Direction Autopilot::steer(const SnakeSim &sim) {
+  auto &board = sim.board();
+  auto &snake = sim.snake();
+  auto head = snake.head();
+
+  Position starts[4];
+  Direction turns[4];
+  int count = 0;
+
+  for (auto direct : directions) {
+    auto next = head + to_pos(direct);
+
+    if (!is_reversal(snake.direction(), direct) && board.contains(next) && !board.is_snake(next)) {
+      starts[count] = next;
+      turns[count] = direct;
+      count++;
+    }
+  }
+
+  if (count == 0) {
+    // Boxed in; whichever way it goes, the game is over.
+    return snake.direction() == Direction::None ? Direction::Left : snake.direction();
+  }
+
+  if (!(head == expected)) {
+    ordered = has_cycle() && in_cycle_order(snake);
+  }
+
+  auto chosen = -1;
+
+  if (ordered) {
+    auto around = cycle.size();
+    auto from = place[board.index(head)];
+    auto back = place[board.index(snake[snake.len() - 1])];
+    auto gap = snake.len() == 1 ? around : distance(from, back);
+
+    // A shortcut leaves blocks behind the head that the tail still has to go
+    // round, and every fruit eaten meanwhile holds the tail back a tick. So
+    // one is only taken with room ahead for all the fruit there is, and while
+    // the body and that fruit span under half the cycle.
+    auto fruits = board.len() - board.vacant_len() - snake.len();
+    auto safe = [&](int k) {
+      auto to = place[board.index(starts[k])];
+      return to != npos && distance(from, to) + fruits + shortcut_slack < gap &&
+             2 * (distance(back, to) + 1 + fruits) <= around;
+    };
+
+    if (2 * (distance(back, from) + 1 + fruits) < around) {
+      chosen = search(board, starts, count);
+
+      if (chosen >= 0 && !safe(chosen)) {
+        chosen = -1;
+      }
+
+      // Nothing close: go as far along the cycle as is safe without passing
+      // the fruit it reaches first.
+      if (chosen < 0) {
+        auto target = around;
+        auto fruit = board.fruit_bits().words();
+
+        for (std::size_t word = 0; word < word_len; word++) {
+          for (auto bits = fruit[word]; bits != 0; bits &= bits - 1) {
+            auto to = place[word * 64 + std::size_t(__builtin_ctzll(bits))];
+            if (to != npos) {
+              target = std::min(target, distance(from, to));
+            }
+          }
+        }
+
+        std::size_t furthest = 0;
+        for (int k = 0; k < count; k++) {
+          auto to = place[board.index(starts[k])];
+          if (safe(k) && distance(from, to) <= target && distance(from, to) > furthest) {
+            furthest = distance(from, to);
+            chosen = k;
+          }
+        }
+      }
+    }
+
+    if (chosen < 0) {
+      auto next = cycle[(from + 1) % around];
+
+      for (int k = 0; k < count; k++) {
+        if (board.index(starts[k]) == next) {
+          chosen = k;
+        }
+      }
+    }
+  }
+
+  // Only a move along the cycle keeps the body in order; anything else has
+  // to be checked again next time.
+  expected = chosen >= 0 ? starts[chosen] : Position{npos, npos};
+
+  // Off the cycle, or in the way of it: chase fruit, otherwise keep the most
+  // room to move.
+  if (chosen < 0) {
+    chosen = search(board, starts, count);
+  }
+
+  if (chosen < 0) {
+    int most = -1;
+
+    for (int k = 0; k < count; k++) {
+      int room = 0;
+      for (auto direct : directions) {
+        auto next = starts[k] + to_pos(direct);
+        room += board.contains(next) && !board.is_snake(next) ? 1 : 0;
+      }
+
+      if (room > most) {
+        most = room;
+        chosen = k;
+      }
+    }
+  }
+
+  return turns[chosen];
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// A controller that plays the game by itself, as a soak test and a baseline
+// for agents. It never loses on boards that have a Hamiltonian cycle: it
+// follows the cycle, taking shortcuts towards fruit only while the snake's
+// body still lies in cycle order behind the head. Fruit nearby is found by a
+// breadth-first search that expands bit planes of the board a word at a time
+// rather than queueing blocks one by one.
+
+#include "sim.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Autopilot {
+  static constexpr std::uint32_t npos = std::uint32_t(-1);
+
+  std::size_t horizontal, vertical;
+
+  // The cycle, as each block's place along it and the block at each place.
+  // Boards with both sides odd have no cycle through every block, so one
+  // corner is left out (`npos`); one block thin boards have none at all.
+  std::vector<std::uint32_t> place, cycle;
+
+  std::size_t max_depth;
+
+  // Whether the body was in cycle order when last checked, and where the
+  // head should be next if nobody else steers in between.
+  bool ordered = false;
+  Position expected{npos, npos};
+
+  // Bit planes for the search, one word per 64 blocks. Only the rows the
+  // search reached are touched, and they are cleared again afterwards.
+  std::size_t word_len;
+  std::vector<std::uint64_t> not_first_column, not_last_column;
+  std::vector<std::uint64_t> open, reached;
+  std::vector<std::uint64_t> frontiers[4], grown[4];
+
+  std::size_t distance(std::uint32_t from, std::uint32_t to) const noexcept {
+    return (to + cycle.size() - from) % cycle.size();
+  }
+
+  void build_cycle();
+  bool in_cycle_order(const Snake &snake) const noexcept;
+
+  // Which of the `count` first steps in `starts` begins a shortest path to a
+  // fruit no more than max_depth blocks off, or -1 if none does.
+  int search(const Board &board, const Position *starts, int count);
+
+public:
+  // Plans for boards the size of `board`. Searches give up on fruit further
+  // than `max_depth` moves away and leave it to the cycle, which bounds the
+  // time a step takes on large boards.
+  explicit Autopilot(const Board &board, std::size_t max_depth = 48);
+
+  bool has_cycle() const noexcept { return !cycle.empty(); }
+
+  // The direction to take before the next tick.
+  Direction steer(const SnakeSim &sim);
+
+  // steer(), then turns the snake that way.
+  void drive(SnakeSim &sim) { sim.try_set_direction(steer(sim)); }
+};
@@ -0,0 +1,196 @@
+#include "batch.hpp"
+
+#include "observation.hpp"
+
+static constexpr std::int32_t direction_x[] = {0, -1, 1, 0, 0};
+static constexpr std::int32_t direction_y[] = {0, 0, 0, -1, 1};
+
+BatchSim::BatchSim(std::size_t envs, std::size_t horizontal, std::size_t vertical,
+                   std::uint64_t seed, std::uint64_t first_stream)
+  : _envs(envs), _horizontal(horizontal), _vertical(vertical), _cells(horizontal * vertical),
+    cells(envs * _cells), bodies(envs * _cells), body_first(envs), body_len(envs),
+    head_x(envs), head_y(envs), directions(envs), ticks(envs), vacant(envs * _cells),
+    vacant_slot(envs * _cells), vacant_len(envs), _results(envs), next_x(envs), next_y(envs),
+    moving(envs) {
+  rngs.reserve(envs);
+
+  for (std::size_t env = 0; env < envs; env++) {
+    rngs.emplace_back(seed, first_stream + env);
+  }
+
+  for (std::size_t env = 0; env < envs; env++) {
+    reset(env);
+  }
+}
+
+void BatchSim::set_type(std::size_t env, std::uint32_t index, BlockType type) {
+  auto &cell = cells[env * _cells + index];
+
+  if (is_occupied(cell) != is_occupied(type)) {
+    auto list = &vacant[env * _cells];
+    auto slots = &vacant_slot[env * _cells];
+
+    if (is_occupied(type)) {
+      auto slot = slots[index];
+      auto last = list[--vacant_len[env]];
+
+      list[slot] = last;
+      slots[last] = slot;
+    } else {
+      slots[index] = vacant_len[env];
+      list[vacant_len[env]++] = index;
+    }
+  }
+
+  cell = type;
+}
+
+void BatchSim::spawn_fruit(std::size_t env) {
+  if (vacant_len[env] == 0) {
+    return;
+  }
+
+  set_type(env, vacant[env * _cells + rngs[env].below(vacant_len[env])], BlockType::OccupiedFruit);
+}
+
+void BatchSim::reset(std::size_t env) {
+  auto base = env * _cells;
+
+  for (std::size_t i = 0; i < _cells; i++) {
+    cells[base + i] = BlockType::Vacant;
+    vacant[base + i] = std::uint32_t(i);
+    vacant_slot[base + i] = std::uint32_t(i);
+  }
+
+  vacant_len[env] = std::uint32_t(_cells);
+
+  head_x[env] = std::int32_t(rngs[env].below(std::uint32_t(_horizontal)));
+  head_y[env] = std::int32_t(rngs[env].below(std::uint32_t(_vertical)));
+
+  auto head = std::uint32_t(head_x[env] + head_y[env] * std::int32_t(_horizontal));
+  set_type(env, head, BlockType::OccupiedSnake);
+
+  bodies[base] = head;
+  body_first[env] = 0;
+  body_len[env] = 1;
+
+  directions[env] = Direction::None;
+  ticks[env] = 0;
+  _results[env] = MoveResult::Ok;
+}
+
+void BatchSim::reset_finished() {
+  for (std::size_t env = 0; env < _envs; env++) {
+    if (finished(env)) {
+      reset(env);
+    }
+  }
+}
+
+void BatchSim::step(const Direction *actions) {
+  const auto width = std::int32_t(_horizontal);
+  const auto height = std::int32_t(_vertical);
+
+  // Turning and bounds, branch-free so it vectorises across games.
+  for (std::size_t env = 0; env < _envs; env++) {
+    auto current = std::uint8_t(directions[env]);
+    auto wanted = std::uint8_t(actions[env]);
+
+    bool reverses = direction_x[wanted] + direction_x[current] == 0 &&
+                    direction_y[wanted] + direction_y[current] == 0 && current != 0;
+    auto direction = (wanted == 0 || reverses) ? current : wanted;
+
+    directions[env] = Direction(direction);
+
+    next_x[env] = head_x[env] + direction_x[direction];
+    next_y[env] = head_y[env] + direction_y[direction];
+
+    bool in_bounds = std::uint32_t(next_x[env]) < std::uint32_t(width) &&
+                     std::uint32_t(next_y[env]) < std::uint32_t(height);
+    bool live = !is_fatal(_results[env]) && direction != 0;
+
+    moving[env] = std::uint8_t(live) << std::uint8_t(in_bounds);
+  }
+
+  // `moving` is 0 for games that sit this step out, 1 for one about to hit a
+  // wall and 2 for one whose next block is on the board.
+  for (std::size_t env = 0; env < _envs; env++) {
+    if (moving[env] == 0) {
+      continue;
+    }
+
+    if (moving[env] == 1) {
+      _results[env] = MoveResult::HitWall;
+      continue;
+    }
+
+    if (++ticks[env] % spawn_ticks == 0) {
+      spawn_fruit(env);
+    }
+
+    auto base = env * _cells;
+    auto next = std::uint32_t(next_x[env] + next_y[env] * width);
+    auto type = cells[base + next];
+
+    if (type == BlockType::OccupiedSnake) {
+      _results[env] = MoveResult::HitSelf;
+      continue;
+    }
+
+    auto ring = &bodies[base];
+    bool ate = type == BlockType::OccupiedFruit;
+
+    if (!ate) {
+      auto tail = body_first[env] + body_len[env] - 1;
+      set_type(env, ring[tail >= _cells ? tail - _cells : tail], BlockType::Vacant);
+      body_len[env]--;
+    }
+
+    set_type(env, next, BlockType::OccupiedSnake);
+
+    body_first[env] = body_first[env] == 0 ? std::uint32_t(_cells - 1) : body_first[env] - 1;
+    ring[body_first[env]] = next;
+    body_len[env]++;
+
+    head_x[env] = next_x[env];
+    head_y[env] = next_y[env];
+
+    _results[env] = ate ? MoveResult::Ate : MoveResult::Ok;
+  }
+}
+
+template <typename T>
+static void write_batch(const BatchSim &sim, const BlockType *cells, const std::uint32_t *bodies,
+                        const std::uint32_t *body_first, T *out, std::size_t crop) {
+  auto horizontal = sim.horizontal(), len = sim.len();
+  auto size = observation_size(horizontal, sim.vertical(), crop);
+
+  for (std::size_t env = 0; env < sim.envs(); env++) {
+    auto plane = cells + env * len;
+    auto ring = bodies + env * len;
+    auto first = body_first[env];
+
+    observation::write_planes<T>(
+      horizontal, sim.vertical(), sim.snake_len(env), sim.direction(env),
+      [&](std::size_t nth) {
+        auto at = first + nth;
+        auto index = ring[at >= len ? at - len : at];
+        return Position{std::uint32_t(index % horizontal), std::uint32_t(index / horizontal)};
+      },
+      [&](T *fruit) {
+        for (std::size_t i = 0; i < len; i++) {
+          fruit[i] = plane[i] == BlockType::OccupiedFruit ? observation::on<T> : T(0);
+        }
+      },
+      [&](std::size_t index) { return plane[index] == BlockType::OccupiedFruit; },
+      out + env * size, crop);
+  }
+}
+
+void BatchSim::write_observations(float *out, std::size_t crop) const {
+  write_batch(*this, cells.data(), bodies.data(), body_first.data(), out, crop);
+}
+
+void BatchSim::write_observations(std::uint8_t *out, std::size_t crop) const {
+  write_batch(*this, cells.data(), bodies.data(), body_first.data(), out, crop);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Many independent games of one board size stepped together. Each piece of
+// state is one array across all games so a step is a handful of flat loops
+// the compiler can vectorise, rather than a walk through an object per game.
+
+#include "randomiser.hpp"
+#include "sim.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BatchSim {
+  std::size_t _envs, _horizontal, _vertical, _cells;
+
+  // One plane of BlockType values per game, `_cells` long each.
+  std::vector<BlockType> cells;
+
+  // Each game's body as a ring of block indices, head first, `_cells` long each.
+  std::vector<std::uint32_t> bodies;
+  std::vector<std::uint32_t> body_first;
+  std::vector<std::uint32_t> body_len;
+
+  std::vector<std::int32_t> head_x, head_y;
+  std::vector<Direction> directions;
+  std::vector<std::uint32_t> ticks;
+
+  // Each game's vacant blocks in no particular order, and where each sits
+  // in that list, so a spawn picks one without scanning the plane.
+  std::vector<std::uint32_t> vacant;
+  std::vector<std::uint32_t> vacant_slot;
+  std::vector<std::uint32_t> vacant_len;
+
+  std::vector<MoveResult> _results;
+
+  // Per-step scratch, kept to reuse its capacity.
+  std::vector<std::int32_t> next_x, next_y;
+  std::vector<std::uint8_t> moving;
+
+  // Every game draws from its own stream, so a game plays out the same
+  // whichever batch, shard or thread it is stepped on.
+  std::vector<Randomiser> rngs;
+
+  void set_type(std::size_t env, std::uint32_t index, BlockType type);
+  void spawn_fruit(std::size_t env);
+
+public:
+  // Game `n` draws from stream `first_stream + n` of `seed`.
+  BatchSim(std::size_t envs, std::size_t horizontal, std::size_t vertical, std::uint64_t seed,
+           std::uint64_t first_stream = 0);
+
+  std::size_t envs() const noexcept { return _envs; }
+  std::size_t horizontal() const noexcept { return _horizontal; }
+  std::size_t vertical() const noexcept { return _vertical; }
+  std::size_t len() const noexcept { return _cells; }
+
+  // Starts `env` over with a fresh snake on an empty board.
+  void reset(std::size_t env);
+
+  // Resets every game whose last move ended it.
+  void reset_finished();
+
+  // Turns every game per `actions` (one per game; None keeps going straight,
+  // as does a turn back onto the snake) and moves it one block. Games that
+  // have not been given a direction yet stay put, and finished games are left
+  // as they are until reset.
+  void step(const Direction *actions);
+
+  const BlockType *plane(std::size_t env) const noexcept { return &cells[env * _cells]; }
+
+  // The result of each game's last step.
+  const MoveResult *results() const noexcept { return _results.data(); }
+  bool finished(std::size_t env) const noexcept { return is_fatal(_results[env]); }
+
+  // Every game's observation (see observation.hpp), one after another from
+  // `out`.
+  void write_observations(float *out, std::size_t crop = 0) const;
+  void write_observations(std::uint8_t *out, std::size_t crop = 0) const;
+
+  std::size_t snake_len(std::size_t env) const noexcept { return body_len[env]; }
+  Direction direction(std::size_t env) const noexcept { return directions[env]; }
+};
@@ -0,0 +1,453 @@
+// Microbenchmarks for the game's hot paths, printed to stdout as one JSON
+// document so runs can be compared between releases.
+//
+//   snek-bench [--filter SUBSTRING] [--min-time SECONDS]
+
+#include "autopilot.hpp"
+#include "grid.hpp"
+#include "metrics.hpp"
+#include "observation.hpp"
+#include "pool.hpp"
+#include "randomiser.hpp"
+#include "shader_grid.hpp"
+#include "slab_pool.hpp"
+#include "sim.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef SNEK_VERSION
+#define SNEK_VERSION "unknown"
+#endif
+
+using bench_clock = std::chrono::steady_clock;
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations;
+  double seconds;
+};
+
+static std::vector<Result> results;
+static std::string filter;
+static double min_time = 0.25;
+
+// Times `op` alone, leaving out whatever set-up surrounds it.
+template <typename Op>
+static double timed(Op &&op) {
+  auto start = bench_clock::now();
+  op();
+  return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// Calls `bench` with a doubling number of iterations until its timed part
+// takes at least `min_time`. `bench` returns the seconds that part took.
+template <typename Bench>
+static void run(std::string const &name, Bench &&bench) {
+  if (name.find(filter) == std::string::npos) {
+    return;
+  }
+
+  for (std::uint64_t iterations = 1;; iterations *= 2) {
+    auto seconds = bench(iterations);
+
+    if (seconds >= min_time || iterations >= (std::uint64_t(1) << 40)) {
+      results.push_back(Result{name, iterations, seconds});
+      std::cerr << name << ": " << seconds * 1e9 / double(iterations) << " ns/op\n";
+      return;
+    }
+  }
+}
+
+// A cycle through every block of a board with an even number of rows: along
+// each row from the second column, and back up the first column at the end.
+// A snake following it never runs into itself.
+static Direction along_cycle(Position head, std::size_t horizontal, std::size_t vertical) {
+  if (head.x == 0) {
+    return head.y == 0 ? Direction::Right : Direction::Up;
+  }
+
+  if (head.y % 2 == 0) {
+    return head.x + 1 < horizontal ? Direction::Right : Direction::Down;
+  }
+
+  if (head.x > 1 || head.y + 1 == vertical) {
+    return Direction::Left;
+  }
+
+  return Direction::Down;
+}
+
+static MoveResult step_along_cycle(SnakeSim &sim, bool grow) {
+  auto &board = sim.board();
+  auto head = sim.snake().head();
+
+  sim.try_set_direction(along_cycle(head, board.horizontal(), board.vertical()));
+
+  if (grow) {
+    board.set_type(head + to_pos(sim.direction()), BlockType::OccupiedFruit);
+  }
+
+  return sim.try_move();
+}
+
+static void bench_move(std::size_t length) {
+  run("snake_move/length:" + std::to_string(length), [&](std::uint64_t iterations) {
+    SnakeSim sim(64, 64, 1);
+
+    while (sim.snake().len() < length) {
+      step_along_cycle(sim, true);
+    }
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        step_along_cycle(sim, false);
+      }
+    });
+  });
+}
+
+static void bench_spawn(unsigned fill_percent) {
+  run("spawn_fruit/fill:" + std::to_string(fill_percent), [&](std::uint64_t iterations) {
+    SnakeSim sim(256, 256, 1);
+    auto &board = sim.board();
+
+    Randomiser rng(2);
+    auto filled = [&] { return (board.len() - board.vacant_len()) * 100; };
+
+    while (board.vacant_len() > 1 && filled() < board.len() * fill_percent) {
+      board.set_type(board.nth_vacant(rng.below(std::uint32_t(board.vacant_len()))),
+                     BlockType::OccupiedSnake);
+    }
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        board.clear_changes();
+        sim.spawn_fruit();
+        board.set_type(board.changed()[0], BlockType::Vacant);
+      }
+    });
+  });
+}
+
+
+static void bench_grid_construction(std::size_t side) {
+  run("grid_construct/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    Board board(side, side);
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        Grid grid(board, sf::Vector2f(0.0f, 0.0f));
+      }
+    });
+  });
+}
+
+// The camera follows the head across a 512x512 target, as in the game.
+static void bench_grid_draw(std::size_t side, sf::RenderTexture &target) {
+  run("grid_draw/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    SnakeSim sim(side, side, 1);
+    Grid grid(sim.board(), sf::Vector2f(0.0f, 0.0f));
+
+    while (sim.snake().len() < std::min<std::size_t>(side, 256)) {
+      step_along_cycle(sim, true);
+    }
+
+    auto size = sf::Vector2f(target.getSize());
+    grid.sync(grid.camera(size, sim.snake().head()));
+
+    // One tick per frame, as the game does at its fastest.
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        step_along_cycle(sim, false);
+
+        auto camera = grid.camera(size, sim.snake().head());
+        grid.sync(camera);
+
+        target.setView(camera);
+        target.clear(sf::Color::White);
+        target.draw(grid);
+        target.display();
+      }
+    });
+  });
+}
+
+// Starting over in place on a board in view, as the game does after each
+// one: the sim is cleared and the grid repaints what that changed.
+static void bench_new_game(std::size_t side, sf::RenderTexture &target) {
+  run("new_game/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    SnakeSim sim(side, side, 1);
+    Grid grid(sim.board(), sf::Vector2f(0.0f, 0.0f));
+    auto size = sf::Vector2f(target.getSize());
+
+    double seconds = 0;
+    for (std::uint64_t i = 0; i < iterations; i++) {
+      for (std::size_t moves = 0; moves < std::min<std::size_t>(side, 256); moves++) {
+        step_along_cycle(sim, true);
+      }
+
+      grid.sync(grid.camera(size, sim.snake().head()));
+
+      seconds += timed([&] {
+        sim.restart(i);
+        grid.sync(grid.camera(size, sim.snake().head()));
+      });
+    }
+
+    return seconds;
+  });
+}
+
+// The same for the shader grid, which should cost the CPU the same at any side.
+static void bench_shader_grid_draw(std::size_t side, sf::RenderTexture &target) {
+  run("shader_grid_draw/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    SnakeSim sim(side, side, 1);
+    ShaderGrid grid(sim.board(), sf::Vector2f(0.0f, 0.0f));
+
+    while (sim.snake().len() < std::min<std::size_t>(side, 256)) {
+      step_along_cycle(sim, true);
+    }
+
+    auto size = sf::Vector2f(target.getSize());
+    grid.sync();
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        step_along_cycle(sim, false);
+        grid.sync();
+
+        target.setView(grid.camera(size, sim.snake().head()));
+        target.clear(sf::Color::White);
+        target.draw(grid);
+        target.display();
+      }
+    });
+  });
+}
+
+// Making and dropping a game, as search does for every branch it tries,
+// from the heap and from a pool, and cloning one into another.
+static void bench_game_memory(std::size_t side) {
+  run("game_create/side:" + std::to_string(side) + "/heap", [&](std::uint64_t iterations) {
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        SnakeSim sim(side, side, i);
+      }
+    });
+  });
+
+  run("game_create/side:" + std::to_string(side) + "/slabs", [&](std::uint64_t iterations) {
+    SlabPool pool;
+    { SnakeSim warm(side, side, 0, spawn_ticks, &pool); }
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        SnakeSim sim(side, side, i, spawn_ticks, &pool);
+      }
+    });
+  });
+
+  run("game_clone/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    SnakeSim from(side, side, 1), to(side, side, 2);
+    while (from.snake().len() < std::min<std::size_t>(side, 256)) {
+      step_along_cycle(from, true);
+    }
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        to.copy_from(from);
+      }
+    });
+  });
+}
+
+// Whole games on the default board with a snake that turns at random.
+static void bench_games() {
+  run("games/19x15", [&](std::uint64_t iterations) {
+    Randomiser policy(3);
+
+    return timed([&] {
+      for (std::uint64_t game = 0; game < iterations; game++) {
+        SnakeSim sim(19, 15, game);
+
+        auto result = MoveResult::Ok;
+        while (!is_fatal(result)) {
+          sim.try_set_direction(Direction(1 + policy.below(4)));
+          result = sim.try_tick();
+        }
+      }
+    });
+  });
+}
+
+// One steering decision on a square board with a fruit due every tick, so
+// there is always something for the search to find.
+static void bench_autopilot(std::size_t side) {
+  run("autopilot_steer/side:" + std::to_string(side), [&](std::uint64_t iterations) {
+    SnakeSim sim(side, side, 5, 1);
+    Autopilot pilot(sim.board());
+
+    double seconds = 0;
+    for (std::uint64_t i = 0; i < iterations; i++) {
+      Direction direct;
+      seconds += timed([&] { direct = pilot.steer(sim); });
+
+      sim.try_set_direction(direct);
+      if (is_fatal(sim.try_tick())) {
+        sim.restart(i);
+      }
+    }
+
+    return seconds;
+  });
+}
+
+// A 256-block snake, so the body plane has work to do; `crop` of zero is the
+// whole board.
+static void bench_observation(std::size_t side, std::size_t crop) {
+  run("observation/side:" + std::to_string(side) + "/crop:" + std::to_string(crop),
+      [&](std::uint64_t iterations) {
+        SnakeSim sim(side, side, 1);
+        while (sim.snake().len() < std::min<std::size_t>(side, 256)) {
+          step_along_cycle(sim, true);
+        }
+
+        std::vector<float> out(observation_size(side, side, crop));
+
+        return timed([&] {
+          for (std::uint64_t i = 0; i < iterations; i++) {
+            write_observation(sim.board(), sim.snake(), out.data(), crop);
+          }
+        });
+      });
+}
+
+// What the game pays for each counter and histogram it updates.
+static void bench_metrics() {
+  run("metrics_add", [&](std::uint64_t iterations) {
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        metrics::add(metrics::Counter::Ticks);
+      }
+    });
+  });
+
+  run("metrics_observe", [&](std::uint64_t iterations) {
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        metrics::observe(metrics::Histogram::TickTime, i);
+      }
+    });
+  });
+}
+
+static void bench_pool(std::size_t envs) {
+  run("pool_step/envs:" + std::to_string(envs), [&](std::uint64_t iterations) {
+    BatchPool pool(envs, 19, 15, 1);
+
+    Randomiser policy(4);
+    std::vector<Direction> actions(envs);
+
+    return timed([&] {
+      for (std::uint64_t i = 0; i < iterations; i++) {
+        for (auto &action : actions) {
+          action = Direction(policy.below(5));
+        }
+
+        pool.step(actions.data());
+      }
+    });
+  });
+}
+
+static void print_json() {
+  std::cout << "{\n  \"context\": {\"version\": \"" SNEK_VERSION "\", \"threads\": "
+            << std::thread::hardware_concurrency() << ", \"min_time\": " << min_time
+            << "},\n  \"benchmarks\": [\n";
+
+  for (std::size_t i = 0; i < results.size(); i++) {
+    auto const &result = results[i];
+
+    std::cout << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+              << ", \"ns_per_op\": " << result.seconds * 1e9 / double(result.iterations)
+              << ", \"ops_per_second\": " << double(result.iterations) / result.seconds << "}"
+              << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+
+  std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+      min_time = std::strtod(argv[++i], nullptr);
+    } else {
+      std::cerr << "usage: " << argv[0] << " [--filter SUBSTRING] [--min-time SECONDS]\n";
+      return 1;
+    }
+  }
+
+  for (std::size_t length : {1, 16, 256, 2048}) {
+    bench_move(length);
+  }
+
+  for (unsigned fill : {0, 50, 90, 99}) {
+    bench_spawn(fill);
+  }
+
+  bench_games();
+
+  for (std::size_t side : {16, 256}) {
+    bench_game_memory(side);
+  }
+  bench_pool(4096);
+  bench_metrics();
+
+  for (std::size_t side : {19, 1000}) {
+    bench_observation(side, 0);
+    bench_observation(side, 11);
+  }
+
+  for (std::size_t side : {19, 1000}) {
+    bench_autopilot(side);
+  }
+
+  // Everything from here on needs a GL context, which the render texture
+  // brings with it.
+  sf::RenderTexture target;
+  if (target.create(512, 512)) {
+    for (std::size_t side : {16, 256}) {
+      bench_grid_construction(side);
+    }
+
+    for (std::size_t side : {16, 256, 1000}) {
+      bench_grid_draw(side, target);
+    }
+
+    for (std::size_t side : {16, 1000}) {
+      bench_new_game(side, target);
+    }
+
+    if (ShaderGrid::available()) {
+      for (std::size_t side : {16, 256, 1000}) {
+        bench_shader_grid_draw(side, target);
+      }
+    }
+  } else {
+    std::cerr << "no render target; skipping the rendering benchmarks\n";
+  }
+
+  print_json();
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "storage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+inline int popcount(std::uint64_t word) noexcept { return __builtin_popcountll(word); }
+
+// One bit per block of a board, packed 64 to a word. With `Len` given the
+// words are an exactly sized array inside the object.
+template <std::size_t Len = dynamic_extent>
+class BasicBitboard {
+  static constexpr std::size_t Words = (Len + 63) / 64;
+
+  storage_t<std::uint64_t, Words> _words;
+  Extent<Len> _len;
+
+public:
+  explicit BasicBitboard(std::size_t len = Len,
+                         std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+    : _words(Storage<std::uint64_t, Words>::make((len + 63) / 64, 0, memory)), _len(len) {}
+
+  std::size_t len() const noexcept { return _len.value(); }
+
+  bool test(std::size_t index) const noexcept { return (_words[index / 64] >> (index % 64)) & 1u; }
+  void set(std::size_t index) noexcept { _words[index / 64] |= std::uint64_t(1) << (index % 64); }
+  void reset(std::size_t index) noexcept {
+    _words[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+  }
+
+  void clear() noexcept {
+    for (auto &word : _words) {
+      word = 0;
+    }
+  }
+
+  std::size_t count() const noexcept {
+    std::size_t total = 0;
+    for (auto word : _words) {
+      total += popcount(word);
+    }
+
+    return total;
+  }
+
+  // Bits past len() in the last word are always clear.
+  std::size_t word_len() const noexcept { return _words.size(); }
+  const std::uint64_t *words() const noexcept { return _words.data(); }
+  std::uint64_t *words() noexcept { return _words.data(); }
+};
+
+using Bitboard = BasicBitboard<>;
@@ -0,0 +1,159 @@
+#include "broadcast.hpp"
+
+#include "bytes.hpp"
+#include "grid.hpp"
+#include "netplay.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+Broadcast::Broadcast(unsigned short port) {
+  if (listener.listen(port) != sf::Socket::Done)
+    throw std::runtime_error("could not listen for spectators on port " + std::to_string(port));
+
+  listener.setBlocking(false);
+}
+
+bool Broadcast::flush(Spectator &spectator) {
+  while (!spectator.queue.empty()) {
+    auto &frame = *spectator.queue.front();
+    std::size_t sent = 0;
+
+    auto status = spectator.socket.send(frame.data() + spectator.sent,
+                                        frame.size() - spectator.sent, sent);
+    spectator.sent += sent;
+
+    if (status == sf::Socket::Disconnected || status == sf::Socket::Error) {
+      return false;
+    }
+
+    if (spectator.sent < frame.size()) {
+      // The socket is full; the rest goes next time.
+      return true;
+    }
+
+    spectator.queue.pop_front();
+    spectator.sent = 0;
+  }
+
+  return true;
+}
+
+void Broadcast::poll(const SpectatorEncoder &encoder) {
+  for (;;) {
+    auto joining = std::make_unique<Spectator>();
+    if (listener.accept(joining->socket) != sf::Socket::Done) {
+      break;
+    }
+
+    joining->socket.setBlocking(false);
+
+    auto &catch_up = encoder.catch_up();
+    joining->queue.assign(catch_up.begin(), catch_up.end());
+    spectators.push_back(std::move(joining));
+  }
+
+  spectators.erase(std::remove_if(spectators.begin(), spectators.end(),
+                                  [](const std::unique_ptr<Spectator> &spectator) {
+                                    return spectator->queue.size() > max_queued ||
+                                           !flush(*spectator);
+                                  }),
+                   spectators.end());
+}
+
+void Broadcast::publish(const Frame &frame) {
+  for (auto &spectator : spectators) {
+    spectator->queue.push_back(frame);
+  }
+}
+
+int watch(sf::RenderWindow &window, const char *address) {
+  sf::IpAddress host;
+  unsigned short port = 0;
+
+  if (!parse_address(address, host, port)) {
+    std::cerr << "not a HOST:PORT: " << address << "\n";
+    return 1;
+  }
+
+  sf::TcpSocket socket;
+  if (socket.connect(host, port, sf::seconds(5.0f)) != sf::Socket::Done) {
+    std::cerr << "could not connect to " << address << "\n";
+    return 1;
+  }
+
+  socket.setBlocking(false);
+
+  SpectatorDecoder decoder;
+  std::optional<Grid> grid;
+  std::uint64_t board = 0;
+
+  std::uint8_t incoming[4096];
+  std::string title;
+
+  while (window.isOpen()) {
+    auto event = sf::Event();
+    while (window.pollEvent(event)) {
+      if (event.type == sf::Event::Closed) {
+        window.close();
+      }
+    }
+
+    if (!window.isOpen()) {
+      break;
+    }
+
+    std::size_t received = 0;
+    auto status = sf::Socket::Done;
+
+    while ((status = socket.receive(incoming, sizeof incoming, received)) == sf::Socket::Done) {
+      try {
+        decoder.feed(incoming, received);
+      } catch (FormatError const &ex) {
+        std::cerr << "bad spectator stream: " << ex.what() << "\n";
+        return 1;
+      }
+    }
+
+    if (status == sf::Socket::Disconnected || status == sf::Socket::Error) {
+      std::cerr << "the game went away\n";
+      return 0;
+    }
+
+    if (!decoder.has_board()) {
+      sf::sleep(sf::milliseconds(16));
+      continue;
+    }
+
+    if (!grid || board != decoder.boards()) {
+      grid.reset();
+      grid.emplace(decoder.board(), sf::Vector2f(12.0f, 8.0f));
+      board = decoder.boards();
+    }
+
+    auto next = "watching " + std::string(address) + " - tick " + std::to_string(decoder.tick());
+    if (next != title) {
+      title = next;
+      window.setTitle("Snek : " + title);
+    }
+
+    auto &shown = decoder.board();
+    auto middle = Position{std::uint32_t(shown.horizontal() / 2),
+                           std::uint32_t(shown.vertical() / 2)};
+    auto camera = grid->camera(sf::Vector2f(window.getSize()), middle);
+    grid->sync(camera);
+
+    window.clear(sf::Color::White);
+    window.setView(camera);
+    window.draw(*grid);
+    window.display();
+
+    sf::sleep(sf::milliseconds(16));
+  }
+
+  return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Spectators over TCP: the game serves a SpectatorEncoder's frames to
+// everyone connected, and watch() is the other end.
+
+#include "spectate.hpp"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+
+class Broadcast {
+  struct Spectator {
+    sf::TcpSocket socket;
+
+    // Frames not yet all sent, each shared with every other spectator, and
+    // how much of the first has gone.
+    std::deque<Frame> queue;
+    std::size_t sent = 0;
+  };
+
+  // A spectator this many frames behind is not keeping up at all, and is
+  // dropped rather than queued for without end.
+  static constexpr std::size_t max_queued = 1024;
+
+  sf::TcpListener listener;
+  std::vector<std::unique_ptr<Spectator>> spectators;
+
+  // Sends what the socket takes without blocking; false once it is gone.
+  static bool flush(Spectator &spectator);
+
+public:
+  // Listens on `port`; throws std::runtime_error if it cannot.
+  explicit Broadcast(unsigned short port);
+
+  // Lets in anyone waiting to join, starting them from `encoder`'s latest
+  // keyframe, and sends everyone what has not gone yet.
+  void poll(const SpectatorEncoder &encoder);
+
+  // Queues `frame` for every spectator.
+  void publish(const Frame &frame);
+
+  std::size_t size() const noexcept { return spectators.size(); }
+};
+
+// Spectates the game served at `address` (HOST:PORT) in `window` until the
+// window is closed or the game goes away, and returns the exit status for
+// main().
+int watch(sf::RenderWindow &window, const char *address);
@@ -0,0 +1,102 @@
+#pragma once
+
+// Little-endian and LEB128 varint encoding for the binary formats.
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+inline void put_u8(std::vector<std::uint8_t> &out, std::uint8_t value) { out.push_back(value); }
+
+inline void put_u32(std::vector<std::uint8_t> &out, std::uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out.push_back(std::uint8_t(value >> (8 * i)));
+  }
+}
+
+inline void put_u64(std::vector<std::uint8_t> &out, std::uint64_t value) {
+  for (int i = 0; i < 8; i++) {
+    out.push_back(std::uint8_t(value >> (8 * i)));
+  }
+}
+
+inline void put_varint(std::vector<std::uint8_t> &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(std::uint8_t(value | 0x80));
+    value >>= 7;
+  }
+
+  out.push_back(std::uint8_t(value));
+}
+
+inline std::uint32_t load_u32(const std::uint8_t *bytes) noexcept {
+  return std::uint32_t(bytes[0]) | std::uint32_t(bytes[1]) << 8 | std::uint32_t(bytes[2]) << 16 |
+         std::uint32_t(bytes[3]) << 24;
+}
+
+inline std::uint64_t load_u64(const std::uint8_t *bytes) noexcept {
+  return std::uint64_t(load_u32(bytes)) | std::uint64_t(load_u32(bytes + 4)) << 32;
+}
+
+struct FormatError : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+// Reads back what the put_ functions wrote, throwing FormatError rather
+// than reading past the end.
+class ByteReader {
+  const std::uint8_t *first, *pos, *last;
+
+  void need(std::size_t len) const {
+    if (std::size_t(last - pos) < len)
+      throw FormatError("unexpected end of data");
+  }
+
+public:
+  ByteReader(const std::uint8_t *data, std::size_t len) noexcept
+    : first(data), pos(data), last(data + len) {}
+
+  std::size_t offset() const noexcept { return std::size_t(pos - first); }
+  std::size_t remaining() const noexcept { return std::size_t(last - pos); }
+  const std::uint8_t *here() const noexcept { return pos; }
+
+  void seek(std::size_t offset) {
+    if (offset > std::size_t(last - first))
+      throw FormatError("offset past the end of data");
+
+    pos = first + offset;
+  }
+
+  const std::uint8_t *skip(std::size_t len) {
+    need(len);
+
+    auto start = pos;
+    pos += len;
+    return start;
+  }
+
+  std::uint8_t u8() {
+    need(1);
+    return *pos++;
+  }
+
+  std::uint32_t u32() { return load_u32(skip(4)); }
+
+  std::uint64_t u64() { return load_u64(skip(8)); }
+
+  std::uint64_t varint() {
+    std::uint64_t value = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+      auto byte = u8();
+      value |= std::uint64_t(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+
+    throw FormatError("varint too long");
+  }
+};
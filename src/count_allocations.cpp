@@ -0,0 +1,54 @@
+// Replaces the global operator new with one that counts every allocation
+// towards metrics::thread_allocations(), for the programs that link it.
+
+#include "metrics.hpp"
+
+#include <cstdlib>
+#include <new>
+
+static void *allocate(std::size_t len, std::size_t alignment) {
+  metrics::count_allocation();
+
+  if (len == 0) {
+    len = 1;
+  }
+
+  for (;;) {
+    void *memory = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+      memory = std::malloc(len);
+    } else if (posix_memalign(&memory, alignment, len) != 0) {
+      memory = nullptr;
+    }
+
+    if (memory != nullptr) {
+      return memory;
+    }
+
+    auto handler = std::get_new_handler();
+    if (handler == nullptr)
+      throw std::bad_alloc();
+
+    handler();
+  }
+}
+
+void *operator new(std::size_t len) { return allocate(len, 0); }
+void *operator new[](std::size_t len) { return allocate(len, 0); }
+void *operator new(std::size_t len, std::align_val_t alignment) {
+  return allocate(len, std::size_t(alignment));
+}
+void *operator new[](std::size_t len, std::align_val_t alignment) {
+  return allocate(len, std::size_t(alignment));
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,290 @@
+#include "grid.hpp"
+
+#include <algorithm>
+
+static const sf::Color palette[1 + fruit_colours] = {
+  sf::Color::Green, // The snake, and the outline of vacant blocks
+  sf::Color::Red,
+  sf::Color::Blue,
+  sf::Color(0xFF, 0xA5, 0x00), // Orange
+};
+
+sf::Color to_colour(std::uint8_t colour) {
+  return palette[colour];
+}
+
+sf::View follow(const Board &board, sf::Vector2f origin, sf::Vector2f size,
+                Position focus) noexcept {
+  auto axis = [](float origin, float board, float view, float focus) {
+    if (board <= view) {
+      return origin + board / 2.0f;
+    }
+
+    return std::min(std::max(focus, origin + view / 2.0f), origin + board - view / 2.0f);
+  };
+
+  auto board_width = float(board.horizontal()) * block_len + line_len;
+  auto board_height = float(board.vertical()) * block_len + line_len;
+
+  auto centre = origin + sf::Vector2f(float(focus.x) + 0.5f, float(focus.y) + 0.5f) * block_len;
+
+  sf::View view;
+  view.setSize(size);
+  view.setCenter(axis(origin.x, board_width, size.x, centre.x),
+                 axis(origin.y, board_height, size.y, centre.y));
+
+  return view;
+}
+
+static void set_quad(sf::Vertex *quad, sf::Vector2f pos, sf::Vector2f size) noexcept {
+  quad[0].position = pos;
+  quad[1].position = sf::Vector2f(pos.x + size.x, pos.y);
+  quad[2].position = pos + size;
+  quad[3].position = sf::Vector2f(pos.x, pos.y + size.y);
+}
+
+static void layout(sf::Vertex *quads, sf::Vector2f pos) noexcept {
+  set_quad(quads, pos, sf::Vector2f(block_len, block_len));
+  set_quad(quads + 4, pos, sf::Vector2f(block_len + line_len, line_len));
+  set_quad(quads + 8, sf::Vector2f(pos.x + block_len, pos.y), sf::Vector2f(line_len, block_len));
+  set_quad(quads + 12, sf::Vector2f(pos.x, pos.y + block_len),
+           sf::Vector2f(block_len + line_len, line_len));
+  set_quad(quads + 16, pos, sf::Vector2f(line_len, block_len));
+}
+
+// A whole chunk laid out at the origin, row by row, made once for every grid.
+// Chunks are copied out of it moved into place, each row in one go, rather
+// than working out every block's quads afresh.
+static const std::vector<sf::Vertex> &chunk_layout() {
+  static const auto vertices = [] {
+    std::vector<sf::Vertex> vertices(chunk_len * chunk_len * block_vertices);
+
+    for (std::size_t y = 0; y < chunk_len; y++) {
+      for (std::size_t x = 0; x < chunk_len; x++) {
+        layout(&vertices[(x + y * chunk_len) * block_vertices],
+               sf::Vector2f(float(x), float(y)) * block_len);
+      }
+    }
+
+    return vertices;
+  }();
+
+  return vertices;
+}
+
+void Grid::paint(Chunk &chunk, std::size_t index) noexcept {
+  auto quads = &chunk.vertices[block_in_chunk(chunk, index) * block_vertices];
+
+  auto block = board.block(index);
+  auto colour = to_colour(block.colour);
+  auto fill = colour;
+  if (!is_occupied(block.type)) {
+    fill.a = 0;
+  }
+
+  for (std::size_t i = 0; i < 4; i++) {
+    quads[i].color = fill;
+  }
+
+  for (std::size_t i = 4; i < block_vertices; i++) {
+    quads[i].color = colour;
+  }
+}
+
+Grid::Grid(Board &board, sf::Vector2f pos)
+  : board(board), origin(pos), chunks_horizontal((board.horizontal() + chunk_len - 1) / chunk_len),
+    chunks_vertical((board.vertical() + chunk_len - 1) / chunk_len) {
+  chunks.reserve(chunks_horizontal * chunks_vertical);
+
+  for (std::size_t y = 0; y < vertical(); y += chunk_len) {
+    for (std::size_t x = 0; x < horizontal(); x += chunk_len) {
+      chunks.emplace_back();
+
+      auto &chunk = chunks.back();
+      chunk.x = x;
+      chunk.y = y;
+      chunk.horizontal = std::min(chunk_len, horizontal() - x);
+      chunk.vertical = std::min(chunk_len, vertical() - y);
+    }
+  }
+}
+
+void Grid::materialise(Chunk &chunk) {
+  auto &layout = chunk_layout();
+  auto row_len = chunk.horizontal * block_vertices;
+  auto corner = position(chunk.x + chunk.y * horizontal());
+
+  chunk.vertices.resize(chunk.len() * block_vertices);
+
+  for (std::size_t y = 0; y < chunk.vertical; y++) {
+    auto from = &layout[y * chunk_len * block_vertices];
+    auto to = &chunk.vertices[y * row_len];
+
+    for (std::size_t i = 0; i < row_len; i++) {
+      to[i].position = from[i].position + corner;
+    }
+
+    for (std::size_t x = 0; x < chunk.horizontal; x++) {
+      paint(chunk, (chunk.x + x) + (chunk.y + y) * horizontal());
+    }
+  }
+
+  if (sf::VertexBuffer::isAvailable()) {
+    chunk.buffer.create(chunk.vertices.getVertexCount());
+  }
+
+  chunk.dirty.clear();
+  chunk.stale = true;
+  live_chunks++;
+}
+
+void Grid::evict(Chunk &chunk) {
+  chunk.vertices.clear();
+  chunk.buffer = sf::VertexBuffer(sf::Quads, sf::VertexBuffer::Dynamic);
+  chunk.dirty = std::vector<std::uint32_t>();
+  live_chunks--;
+}
+
+std::size_t Grid::upload(Chunk &chunk) {
+  if (chunk.buffer.getVertexCount() == 0) {
+    // Without a buffer every draw sends the whole array.
+    return chunk.vertices.getVertexCount();
+  }
+
+  if (chunk.stale) {
+    chunk.buffer.update(&chunk.vertices[0]);
+    chunk.stale = false;
+    chunk.dirty.clear();
+    return chunk.vertices.getVertexCount();
+  }
+
+  std::size_t sent = 0;
+  auto &dirty = chunk.dirty;
+
+  std::sort(dirty.begin(), dirty.end());
+
+  // Neighbouring blocks are adjacent in the array too, so runs of them go up in one update.
+  for (std::size_t i = 0; i < dirty.size();) {
+    std::size_t run = 1;
+    while (i + run < dirty.size() && dirty[i + run] == dirty[i] + run) {
+      run++;
+    }
+
+    chunk.buffer.update(&chunk.vertices[dirty[i] * block_vertices], run * block_vertices,
+                        unsigned(dirty[i] * block_vertices));
+    sent += run * block_vertices;
+    i += run;
+  }
+
+  dirty.clear();
+  return sent;
+}
+
+Grid::ChunkRange Grid::in_view(const sf::View &view) const noexcept {
+  auto centre = view.getCenter() - origin;
+  auto half = view.getSize() / 2.0f;
+
+  auto board_width = float(horizontal()) * block_len + line_len;
+  auto board_height = float(vertical()) * block_len + line_len;
+
+  if (len() == 0 || centre.x + half.x < 0.0f || centre.y + half.y < 0.0f ||
+      centre.x - half.x > board_width || centre.y - half.y > board_height) {
+    return ChunkRange{0, 0, 0, 0, true};
+  }
+
+  auto block_at = [](float offset, std::size_t blocks) {
+    return std::min(std::size_t(std::max(0.0f, offset) / block_len), blocks - 1);
+  };
+
+  return ChunkRange{block_at(centre.x - half.x, horizontal()) / chunk_len,
+                    block_at(centre.y - half.y, vertical()) / chunk_len,
+                    block_at(centre.x + half.x, horizontal()) / chunk_len,
+                    block_at(centre.y + half.y, vertical()) / chunk_len, false};
+}
+
+void Grid::sync(const sf::View &view) {
+  frame++;
+
+  for (auto index : board.changed()) {
+    auto &chunk = chunks[chunk_of(index)];
+    if (!chunk.live()) {
+      continue;
+    }
+
+    paint(chunk, index);
+
+    // Past a quarter of the chunk, one whole update beats many small ones.
+    if (!chunk.stale) {
+      chunk.dirty.push_back(std::uint32_t(block_in_chunk(chunk, index)));
+
+      if (chunk.dirty.size() * 4 >= chunk.len()) {
+        chunk.stale = true;
+        chunk.dirty.clear();
+      }
+    }
+  }
+
+  board.clear_changes();
+
+  last_upload = 0;
+  last_visible = 0;
+
+  auto range = in_view(view);
+  if (!range.empty) {
+    for (auto y = range.top; y <= range.bottom; y++) {
+      for (auto x = range.left; x <= range.right; x++) {
+        auto &chunk = chunks[x + y * chunks_horizontal];
+        if (!chunk.live()) {
+          materialise(chunk);
+        }
+
+        chunk.last_seen = frame;
+        last_upload += upload(chunk);
+        last_visible++;
+      }
+    }
+  }
+
+  // Keep a margin of chunks around the view live, so panning back and forth
+  // does not rebuild them, but no more than that.
+  auto budget = std::max<std::size_t>(16, 4 * last_visible);
+  if (live_chunks > budget) {
+    std::vector<std::size_t> idle;
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+      if (chunks[i].live() && chunks[i].last_seen != frame) {
+        idle.push_back(i);
+      }
+    }
+
+    std::sort(idle.begin(), idle.end(), [&](std::size_t lhs, std::size_t rhs) {
+      return chunks[lhs].last_seen < chunks[rhs].last_seen;
+    });
+
+    for (std::size_t i = 0; i < idle.size() && live_chunks > budget; i++) {
+      evict(chunks[idle[i]]);
+    }
+  }
+}
+
+void Grid::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  auto range = in_view(target.getView());
+  if (range.empty) {
+    return;
+  }
+
+  for (auto y = range.top; y <= range.bottom; y++) {
+    for (auto x = range.left; x <= range.right; x++) {
+      auto &chunk = chunks[x + y * chunks_horizontal];
+
+      if (!chunk.live()) {
+        continue;
+      }
+
+      if (chunk.buffer.getVertexCount() == 0) {
+        target.draw(chunk.vertices, states);
+      } else {
+        target.draw(chunk.buffer, states);
+      }
+    }
+  }
+}
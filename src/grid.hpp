@@ -0,0 +1,118 @@
+#pragma once
+
+#include "sim.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr float block_len = 25.0f;
+static constexpr float line_len = 1.0f;
+
+// Every block is laid out as five quads in its chunk's vertex array: the fill
+// followed by its top, right, bottom and left edges.
+static constexpr std::size_t block_vertices = 4 * 5;
+
+sf::Color to_colour(std::uint8_t colour);
+
+// A view of `size` over `board` laid out at `origin`, that keeps block `focus`
+// in the middle where the board is bigger than it, without showing past the
+// board's edges, and puts the board in the middle where the board is smaller.
+sf::View follow(const Board &board, sf::Vector2f origin, sf::Vector2f size,
+                Position focus) noexcept;
+
+// Boards are drawn in square chunks of this many blocks a side, each with a
+// vertex array and buffer of its own, so big boards cost only what is in view.
+static constexpr std::size_t chunk_len = 32;
+
+// Draws a board. The grid only ever reads the board; sync() repaints the
+// blocks the board reports as changed.
+class Grid : public sf::Drawable {
+  struct Chunk {
+    // The first block and how many blocks wide and high it is.
+    std::size_t x, y, horizontal, vertical;
+
+    // Empty until the chunk first comes into view, and emptied again once
+    // it has been out of view long enough to be evicted.
+    sf::VertexArray vertices{sf::Quads};
+
+    // The GPU copy of `vertices`, updated only for the blocks in `dirty`, or
+    // whole when `stale`.
+    sf::VertexBuffer buffer{sf::Quads, sf::VertexBuffer::Dynamic};
+    std::vector<std::uint32_t> dirty;
+    bool stale = true;
+
+    std::uint64_t last_seen = 0;
+
+    bool live() const noexcept { return vertices.getVertexCount() != 0; }
+    std::size_t len() const noexcept { return horizontal * vertical; }
+  };
+
+  // Chunks `left` to `right` across and `top` to `bottom` down, inclusive.
+  struct ChunkRange {
+    std::size_t left, top, right, bottom;
+    bool empty;
+  };
+
+  Board &board;
+  sf::Vector2f origin;
+
+  std::size_t chunks_horizontal, chunks_vertical;
+  std::vector<Chunk> chunks;
+  std::size_t live_chunks = 0;
+
+  std::uint64_t frame = 0;
+  std::size_t last_upload = 0, last_visible = 0;
+
+  std::size_t chunk_of(std::size_t index) const noexcept {
+    auto x = index % horizontal(), y = index / horizontal();
+    return x / chunk_len + y / chunk_len * chunks_horizontal;
+  }
+
+  std::size_t block_in_chunk(const Chunk &chunk, std::size_t index) const noexcept {
+    return (index % horizontal() - chunk.x) + (index / horizontal() - chunk.y) * chunk.horizontal;
+  }
+
+  ChunkRange in_view(const sf::View &view) const noexcept;
+
+  void materialise(Chunk &chunk);
+  void evict(Chunk &chunk);
+  void paint(Chunk &chunk, std::size_t index) noexcept;
+  std::size_t upload(Chunk &chunk);
+
+public:
+  // Lays the board out with its top left corner at `pos`.
+  Grid(Board &board, sf::Vector2f pos);
+
+  // Repaints what changed on the board, and uploads what changed in the
+  // chunks `view` shows. Chunks out of view are brought up to date once
+  // they come into it.
+  void sync(const sf::View &view);
+
+  // follow() for this grid's board.
+  sf::View camera(sf::Vector2f size, Position focus) const noexcept {
+    return follow(board, origin, size, focus);
+  }
+
+  // How many vertices the last sync() sent to the GPU, and how many chunks
+  // it found in view.
+  std::size_t uploaded_vertices() const noexcept { return last_upload; }
+  std::size_t visible_chunks() const noexcept { return last_visible; }
+
+  // Draws the chunks in the target's current view.
+  void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+
+  std::size_t horizontal() const noexcept { return board.horizontal(); }
+  std::size_t vertical() const noexcept { return board.vertical(); }
+  std::size_t len() const noexcept { return board.len(); }
+
+  Block operator[](Position pos) const noexcept { return board.block(pos); }
+  Block operator[](std::size_t pos) const noexcept { return board.block(pos); }
+
+  // Where the top left corner of block `index` is drawn.
+  sf::Vector2f position(std::size_t index) const noexcept {
+    return origin + sf::Vector2f(float(index % horizontal()), float(index / horizontal())) *
+                      block_len;
+  }
+};
@@ -0,0 +1,142 @@
+#include "hud.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+// Glyphs are 3x5 pixels, one row per three bits, top row first.
+struct Glyph {
+  char character;
+  std::uint16_t rows;
+};
+
+static constexpr Glyph font[] = {
+  {'0', 0b111'101'101'101'111}, {'1', 0b010'110'010'010'111}, {'2', 0b111'001'111'100'111},
+  {'3', 0b111'001'111'001'111}, {'4', 0b101'101'111'001'001}, {'5', 0b111'100'111'001'111},
+  {'6', 0b111'100'111'101'111}, {'7', 0b111'001'001'001'001}, {'8', 0b111'101'111'101'111},
+  {'9', 0b111'101'111'001'111}, {'A', 0b010'101'111'101'101}, {'B', 0b110'101'110'101'110},
+  {'C', 0b011'100'100'100'011}, {'D', 0b110'101'101'101'110}, {'E', 0b111'100'110'100'111},
+  {'F', 0b111'100'110'100'100}, {'I', 0b111'010'010'010'111}, {'K', 0b101'101'110'101'101},
+  {'M', 0b101'111'111'101'101}, {'P', 0b110'101'110'100'100}, {'R', 0b110'101'110'101'101},
+  {'S', 0b011'100'010'001'110}, {'T', 0b111'010'010'010'010}, {'U', 0b101'101'101'101'111},
+  {'V', 0b101'101'101'101'010}, {'W', 0b101'101'111'111'101}, {'.', 0b000'000'000'000'010},
+  {':', 0b000'010'000'010'000},
+};
+
+static constexpr float pixel = 2.0f;
+static constexpr float line_height = 7 * pixel;
+static constexpr float graph_height = 40.0f;
+
+static const sf::Color background(0, 0, 0, 0xA0);
+static const sf::Color foreground(0xFF, 0xFF, 0xFF);
+static const sf::Color p50_colour(0x40, 0xC0, 0xFF);
+static const sf::Color p99_colour(0xFF, 0x60, 0x40);
+
+void Hud::Samples::push(float value) noexcept {
+  values[next] = value;
+  next = (next + 1) % samples;
+  count = std::min(count + 1, samples);
+}
+
+float Hud::Samples::latest() const noexcept {
+  return count == 0 ? 0.0f : values[(next + samples - 1) % samples];
+}
+
+float Hud::Samples::percentile(float fraction) const {
+  if (count == 0) {
+    return 0.0f;
+  }
+
+  auto sorted = values;
+  auto nth = std::size_t(fraction * float(count - 1));
+  std::nth_element(sorted.begin(), sorted.begin() + nth, sorted.begin() + count);
+
+  return sorted[nth];
+}
+
+void Hud::record_frame(float seconds, unsigned draws, std::size_t bytes) noexcept {
+  frames.push(seconds);
+  draw_calls = draws;
+  uploaded_bytes = bytes;
+}
+
+void Hud::rect(sf::Vector2f pos, sf::Vector2f size, sf::Color colour) {
+  quads.append(sf::Vertex(pos, colour));
+  quads.append(sf::Vertex(sf::Vector2f(pos.x + size.x, pos.y), colour));
+  quads.append(sf::Vertex(pos + size, colour));
+  quads.append(sf::Vertex(sf::Vector2f(pos.x, pos.y + size.y), colour));
+}
+
+void Hud::text(sf::Vector2f pos, const char *line, sf::Color colour) {
+  for (; *line != '\0'; line++, pos.x += 4 * pixel) {
+    auto glyph = std::find_if(std::begin(font), std::end(font),
+                              [&](const Glyph &glyph) { return glyph.character == *line; });
+    if (glyph == std::end(font)) {
+      continue;
+    }
+
+    for (int bit = 0; bit < 15; bit++) {
+      if ((glyph->rows >> (14 - bit)) & 1u) {
+        rect(sf::Vector2f(pos.x + float(bit % 3) * pixel, pos.y + float(bit / 3) * pixel),
+             sf::Vector2f(pixel, pixel), colour);
+      }
+    }
+  }
+}
+
+void Hud::update() {
+  quads.clear();
+
+  if (!visible) {
+    return;
+  }
+
+  const float width = samples * 2.0f + 8.0f;
+  const sf::Vector2f origin(4.0f, 4.0f);
+
+  rect(origin, sf::Vector2f(width, 4 * line_height + graph_height + 12.0f), background);
+
+  char line[64];
+  auto pos = origin + sf::Vector2f(4.0f, 4.0f);
+
+  auto frame_p50 = frames.percentile(0.5f), frame_p99 = frames.percentile(0.99f);
+  std::snprintf(line, sizeof line, "FRAME %.2fMS", frames.latest() * 1e3f);
+  text(pos, line, foreground);
+  pos.y += line_height;
+  std::snprintf(line, sizeof line, "P50 %.2f P99 %.2f", frame_p50 * 1e3f, frame_p99 * 1e3f);
+  text(pos, line, foreground);
+  pos.y += line_height;
+
+  std::snprintf(line, sizeof line, "TICK %.3fMS P99 %.3f", ticks.latest() * 1e3f,
+                ticks.percentile(0.99f) * 1e3f);
+  text(pos, line, foreground);
+  pos.y += line_height;
+
+  std::snprintf(line, sizeof line, "DRAWS %u UP %zuB", draw_calls, uploaded_bytes);
+  text(pos, line, foreground);
+  pos.y += line_height + 4.0f;
+
+  // Recent frame times, oldest on the left, scaled so p99 sits at 80%.
+  auto scale = graph_height * 0.8f / std::max(frame_p99, 1e-6f);
+  auto bottom = pos.y + graph_height;
+
+  for (std::size_t i = 0; i < frames.count; i++) {
+    auto oldest = frames.count < samples ? 0 : frames.next;
+    auto value = frames.values[(oldest + i) % samples];
+    auto height = std::min(graph_height, value * scale);
+
+    rect(sf::Vector2f(pos.x + float(i) * 2.0f, bottom - height), sf::Vector2f(2.0f, height),
+         foreground);
+  }
+
+  rect(sf::Vector2f(pos.x, bottom - frame_p50 * scale), sf::Vector2f(samples * 2.0f, 1.0f),
+       p50_colour);
+  rect(sf::Vector2f(pos.x, bottom - frame_p99 * scale), sf::Vector2f(samples * 2.0f, 1.0f),
+       p99_colour);
+}
+
+void Hud::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  if (visible && quads.getVertexCount() != 0) {
+    target.draw(quads, states);
+  }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// A profiling overlay: frame and tick times with their rolling p50/p99, a
+// graph of recent frame times, and what the last frame cost the GPU. Text
+// and graph are built from quads in one vertex array using a built-in pixel
+// font, so the whole overlay is one draw call and needs no font file.
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstddef>
+
+class Hud : public sf::Drawable {
+public:
+  static constexpr std::size_t samples = 120;
+
+private:
+  // The last `samples` values, oldest first once `count` reaches `samples`.
+  struct Samples {
+    std::array<float, samples> values{};
+    std::size_t next = 0, count = 0;
+
+    void push(float value) noexcept;
+    float latest() const noexcept;
+    float percentile(float fraction) const;
+  };
+
+  Samples frames, ticks;
+  unsigned draw_calls = 0;
+  std::size_t uploaded_bytes = 0;
+
+  bool visible = false;
+  sf::VertexArray quads;
+
+  void text(sf::Vector2f pos, const char *line, sf::Color colour);
+  void rect(sf::Vector2f pos, sf::Vector2f size, sf::Color colour);
+
+public:
+  Hud() : quads(sf::Quads) {}
+
+  bool shown() const noexcept { return visible; }
+  void toggle() noexcept { visible = !visible; }
+
+  void record_frame(float seconds, unsigned draws, std::size_t bytes) noexcept;
+  void record_tick(float seconds) noexcept { ticks.push(seconds); }
+
+  // Rebuilds the overlay from the latest samples; does nothing while hidden.
+  void update();
+
+  void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+};
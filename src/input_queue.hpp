@@ -0,0 +1,86 @@
+#pragma once
+
+#include "sim.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Turns in the order they were pressed, each with when it was pressed, for
+// the game to take one a tick. One thread pushes and one takes, without
+// locks, so input can be read on a thread of its own.
+class InputQueue {
+public:
+  using clock = std::chrono::steady_clock;
+
+  struct TimedTurn {
+    Direction direction;
+    clock::time_point at;
+  };
+
+  // More turns than this waiting at once are dropped; no one presses that
+  // many keys in a tick.
+  static constexpr std::size_t capacity = 16;
+
+private:
+  static_assert((capacity & (capacity - 1)) == 0, "capacity must be a power of two");
+
+  std::array<TimedTurn, capacity> turns{};
+
+  // Both only ever grow; each is written by one side and read by the other.
+  alignas(64) std::atomic<std::size_t> pushed{0};
+  alignas(64) std::atomic<std::size_t> taken{0};
+
+public:
+  // Queues a turn pressed at `at`, unless the queue is full.
+  bool push(Direction direct, clock::time_point at = clock::now()) noexcept {
+    auto back = pushed.load(std::memory_order_relaxed);
+    if (back - taken.load(std::memory_order_acquire) == capacity) {
+      return false;
+    }
+
+    turns[back % capacity] = TimedTurn{direct, at};
+    pushed.store(back + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // The first turn pressed by `due` that changes `current`, the direction
+  // in effect for the tick due then, or None. Turns that would not change
+  // it, or would reverse it, are dropped on the way; turns pressed after
+  // `due` wait for a later tick. When one is found and `pressed` is given,
+  // it is set to when that turn was pressed.
+  Direction take(Direction current, clock::time_point due,
+                 clock::time_point *pressed = nullptr) noexcept {
+    auto front = taken.load(std::memory_order_relaxed);
+    auto back = pushed.load(std::memory_order_acquire);
+
+    auto found = Direction::None;
+    for (; front != back && turns[front % capacity].at <= due; front++) {
+      auto direct = turns[front % capacity].direction;
+
+      if (direct != current && direct != Direction::None && !is_reversal(current, direct)) {
+        found = direct;
+        if (pressed != nullptr) {
+          *pressed = turns[front % capacity].at;
+        }
+
+        front++;
+        break;
+      }
+    }
+
+    taken.store(front, std::memory_order_release);
+
+    return found;
+  }
+
+  // Drops every waiting turn, for a new game.
+  void clear() noexcept { taken.store(pushed.load(std::memory_order_acquire)); }
+
+  std::size_t size() const noexcept {
+    return pushed.load(std::memory_order_acquire) - taken.load(std::memory_order_acquire);
+  }
+};
@@ -0,0 +1,182 @@
+#include "lockstep.hpp"
+
+#include "bytes.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static constexpr char packet_magic[4] = {'S', 'N', 'K', 'N'};
+static constexpr std::uint8_t packet_version = 1;
+
+Lockstep::Lockstep(MultiSnakeSim &sim, std::size_t local, std::uint64_t session,
+                   std::uint32_t delay, std::uint32_t window)
+  : sim(sim), local(local), session(session), delay(delay), window(window),
+    turns(std::size_t(window) * sim.players(), Direction::None), known(sim.players(), delay),
+    acked(sim.players(), delay), snapshot_len(sim.state_size()) {
+  if (local >= sim.players())
+    throw std::invalid_argument("no such player");
+
+  if (window <= delay)
+    throw std::invalid_argument("the rollback window must be longer than the input delay");
+
+  snapshots.resize(snapshot_len * window);
+}
+
+std::uint32_t Lockstep::confirmed() const noexcept {
+  return *std::min_element(known.begin(), known.end());
+}
+
+std::uint32_t Lockstep::base() const noexcept {
+  return std::min({confirmed(), wrong, sim.ticks()});
+}
+
+std::uint32_t Lockstep::unacked() const noexcept {
+  auto oldest = npos;
+  for (std::size_t peer = 0; peer < acked.size(); peer++) {
+    if (peer != local) {
+      oldest = std::min(oldest, acked[peer]);
+    }
+  }
+
+  return oldest;
+}
+
+void Lockstep::step() noexcept {
+  auto tick = sim.ticks();
+
+  sim.save_state(&snapshots[tick % window * snapshot_len]);
+
+  for (std::size_t player = 0; player < sim.players(); player++) {
+    auto direct = turn_at(tick, player);
+    if (direct != Direction::None) {
+      sim.try_set_direction(player, direct);
+    }
+  }
+
+  sim.tick();
+}
+
+bool Lockstep::advance() noexcept {
+  auto now = sim.ticks();
+
+  if (wrong < now) {
+    sim.restore_state(&snapshots[wrong % window * snapshot_len]);
+
+    _rollbacks++;
+    _replayed += now - wrong;
+    wrong = npos;
+
+    while (sim.ticks() < now) {
+      step();
+    }
+  }
+
+  // Past the window, a turn or snapshot still needed would be overwritten,
+  // whether for playing again here or for sending to a peer.
+  if (now + delay >= base() + window ||
+      std::uint64_t(now) + delay >= std::uint64_t(unacked()) + window) {
+    return false;
+  }
+
+  turns[(now + delay) % window * sim.players() + local] = pending;
+  known[local] = now + delay + 1;
+
+  if (pending != Direction::None && !is_reversal(_heading, pending)) {
+    _heading = pending;
+  }
+
+  pending = Direction::None;
+
+  step();
+  return true;
+}
+
+// A packet is the magic and version, the session, who sent it, how many of
+// the receiver's turns the sender has, then a run of the sender's turns from
+// the first the receiver is missing.
+void Lockstep::packet(std::size_t peer, std::vector<std::uint8_t> &out) const {
+  out.clear();
+
+  for (auto byte : packet_magic) {
+    put_u8(out, std::uint8_t(byte));
+  }
+
+  put_u8(out, packet_version);
+  put_u64(out, session);
+  put_u8(out, std::uint8_t(local));
+  put_varint(out, known[peer]);
+
+  // advance() never gets a window past what `peer` has, so every turn from
+  // there on is still kept.
+  auto first = acked[peer];
+  auto count = known[local] - std::min(first, known[local]);
+
+  put_varint(out, first);
+  put_varint(out, count);
+
+  for (std::uint32_t i = 0; i < count; i++) {
+    put_u8(out, std::uint8_t(turn_at(first + i, local)));
+  }
+}
+
+bool Lockstep::receive(Span<std::uint8_t> packet) noexcept {
+  try {
+    ByteReader in(packet.items, packet.size());
+
+    for (auto byte : packet_magic) {
+      if (in.u8() != std::uint8_t(byte)) {
+        return false;
+      }
+    }
+
+    if (in.u8() != packet_version || in.u64() != session) {
+      return false;
+    }
+
+    auto sender = std::size_t(in.u8());
+    if (sender >= sim.players() || sender == local) {
+      return false;
+    }
+
+    auto ack = in.varint();
+    auto first = in.varint();
+    auto count = in.varint();
+
+    if (ack > known[local] || count > in.remaining()) {
+      return false;
+    }
+
+    acked[sender] = std::max(acked[sender], std::uint32_t(ack));
+
+    // Only a run that carries on from what is already known is any use; the
+    // sender starts from what it was last told, so one always turns up.
+    for (std::uint64_t i = 0; i < count; i++) {
+      auto tick = first + i;
+      auto direct = Direction(in.u8());
+
+      if (direct > Direction::Down) {
+        return false;
+      }
+
+      if (tick < known[sender]) {
+        continue;
+      }
+
+      if (tick > known[sender] || tick >= std::uint64_t(base()) + window) {
+        break;
+      }
+
+      turns[tick % window * sim.players() + sender] = direct;
+      known[sender]++;
+
+      // Played already on the guess that they did not turn.
+      if (tick < sim.ticks() && direct != Direction::None) {
+        wrong = std::min(wrong, std::uint32_t(tick));
+      }
+    }
+  } catch (FormatError const &) {
+    return false;
+  }
+
+  return true;
+}
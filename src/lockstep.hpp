@@ -0,0 +1,113 @@
+#pragma once
+
+// Lockstep play of one MultiSnakeSim across several machines, each running
+// its own copy and driving one player. Peers only ever send each other
+// their player's turns, one per tick, and every copy plays the same game
+// because the game is deterministic.
+//
+// A local turn is put `delay` ticks ahead, so it usually reaches the other
+// peers before they play that tick. Until a remote player's turn arrives
+// they are taken not to have turned; if they did, the game is rolled back
+// to the snapshot from before that tick and played forward again, so a
+// slow peer never holds up the local game unless it falls more than the
+// window behind, in its turns or in acknowledging ours. Snapshots live in
+// buffers allocated up front.
+//
+// Every packet carries all the sender's turns the receiver has not said it
+// has, so a lost packet is covered by the next one. The transport is up to
+// the caller: packet() builds the bytes for a peer and receive() takes
+// bytes from one.
+
+#include "multisim.hpp"
+#include "storage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Lockstep {
+public:
+  static constexpr std::uint32_t default_delay = 2;
+  static constexpr std::uint32_t default_window = 32;
+
+private:
+  static constexpr std::uint32_t npos = std::uint32_t(-1);
+
+  MultiSnakeSim &sim;
+  std::size_t local;
+  std::uint64_t session;
+  std::uint32_t delay, window;
+
+  // Turns of player `p` for tick `t` at `t % window * players + p`, for the
+  // ticks below known[p]. Every player's first `delay` turns are known to be
+  // no turn at all.
+  std::vector<Direction> turns;
+  std::vector<std::uint32_t> known;
+
+  // How many of the local player's turns each peer says it has. Local turns
+  // from the fewest on are kept until every peer has them.
+  std::vector<std::uint32_t> acked;
+
+  // The game as it was before tick `t`, at `t % window`, for every tick from
+  // base() on.
+  std::vector<std::uint8_t> snapshots;
+  std::size_t snapshot_len;
+
+  // The first tick played with a remote turn guessed wrong, or npos.
+  std::uint32_t wrong = npos;
+
+  Direction pending = Direction::None;
+  Direction _heading = Direction::None;
+
+  std::uint64_t _rollbacks = 0, _replayed = 0;
+
+  Direction turn_at(std::uint32_t tick, std::size_t player) const noexcept {
+    return tick < known[player] ? turns[tick % window * known.size() + player] : Direction::None;
+  }
+
+  // The oldest tick whose turns may still be read: one that may have to be
+  // played again, or the next to play, for a peer that has heard more than
+  // it has played.
+  std::uint32_t base() const noexcept;
+
+  // The oldest local turn some peer may still need sent, or npos alone.
+  std::uint32_t unacked() const noexcept;
+
+  void step() noexcept;
+
+public:
+  // Plays `local`'s side of `sim`, which must be new. Every peer has to use
+  // the same `session`, which packets from other games fail to match.
+  Lockstep(MultiSnakeSim &sim, std::size_t local, std::uint64_t session,
+           std::uint32_t delay = default_delay, std::uint32_t window = default_window);
+
+  // The local player's turn for the next tick; a later turn before then
+  // replaces it.
+  void turn(Direction direct) noexcept { pending = direct; }
+
+  // Where the local snake will be heading once its turns so far are in, for
+  // checking the next one against.
+  Direction heading() const noexcept { return _heading; }
+
+  // Plays the next tick, first rolling back to fix any wrong guesses. Returns
+  // false, and plays nothing, while some peer is a window behind or has yet
+  // to acknowledge the local turn a window back.
+  bool advance() noexcept;
+
+  // Every tick below this was played with every player's real turn.
+  std::uint32_t confirmed() const noexcept;
+
+  // The next packet for player `peer`, in `out`.
+  void packet(std::size_t peer, std::vector<std::uint8_t> &out) const;
+
+  // Takes in a packet from a peer. Returns false, ignoring it, for anything
+  // that is not a packet from this session.
+  bool receive(Span<std::uint8_t> packet) noexcept;
+
+  std::size_t local_player() const noexcept { return local; }
+
+  // How many times the game was rolled back, and how many ticks were played
+  // again because of it.
+  std::uint64_t rollbacks() const noexcept { return _rollbacks; }
+  std::uint64_t replayed_ticks() const noexcept { return _replayed; }
+};
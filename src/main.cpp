@@ -1,399 +1,543 @@
+#include "autopilot.hpp"
+#include "broadcast.hpp"
+#include "grid.hpp"
+#include "hud.hpp"
+#include "input_queue.hpp"
+#include "metrics.hpp"
+#include "metrics_endpoint.hpp"
+#include "netplay.hpp"
+#include "replay.hpp"
+#include "shader_grid.hpp"
+#include "sim.hpp"
+#include "timestep.hpp"
+#include "trace.hpp"
+
 #include <SFML/Graphics.hpp>
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/System/Vector2.hpp>
 #include <SFML/Window/VideoMode.hpp>
+#include <algorithm>
 #include <chrono>
-#include <cstddef>
+#include <cmath>
 #include <cstdint>
-#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
 #include <random>
-#include <thread>
-#include <tuple>
+#include <string>
+#include <stdexcept>
 #include <vector>
 
-static constexpr float block_len = 25.0f;
+static char const *title = "Snek";
 
-enum class BlockType : std::uint8_t {
-  Vacant,
-  OccupiedSnake,
-  OccupiedFruit,
+enum class GameStates : uint8_t {
+  Start,
+  InProgress,
+  End,
 };
 
-inline constexpr bool is_occupied(BlockType type) {
-  return type == BlockType::OccupiedFruit || type == BlockType::OccupiedSnake;
-}
+enum class RenderMode : uint8_t {
+  // Draw every frame, paced by the display's refresh.
+  VSync,
+  // Draw every frame, at most `fps` a second.
+  Capped,
+  // Draw only after a tick or an event, and sleep in between.
+  OnChange,
+};
 
-class Block : public sf::Drawable {
-  BlockType m_type = BlockType::Vacant;
-  sf::Color m_colour = sf::Color::Green;
+enum class GridMode : uint8_t {
+  // One quad and a shader over a texture of the board, where there are shaders.
+  Shader,
+  // Vertex arrays in chunks, which works everywhere.
+  Vertices,
+};
 
-  sf::VertexArray m_arr;
+struct Options {
+  float tick_rate = 4.0f;
+  RenderMode render = RenderMode::OnChange;
+  GridMode grid = GridMode::Shader;
+  unsigned fps = 60;
+  // Where to write a replay of each game, if anywhere: the first goes to
+  // PATH, the ones after it to PATH.1, PATH.2 and on.
+  const char *record = nullptr;
+  bool autopilot = false;
+  std::size_t horizontal = 19, vertical = 15;
+  // A fixed seed, say for networked games, which all need the same one.
+  std::optional<std::uint64_t> seed;
+  // Every networked player's HOST:PORT in player order, and which is us.
+  std::vector<const char *> peers;
+  std::size_t player = 0;
+  std::uint32_t delay = Lockstep::default_delay;
+  // The port to serve spectators on, if any, or the game to spectate.
+  unsigned short broadcast = 0;
+  const char *watch = nullptr;
+  // The port to serve metrics on, if any, and how often to write them to
+  // stderr, if at all.
+  unsigned short metrics = 0;
+  float stats_seconds = 0.0f;
+};
 
-public:
-  Block() noexcept
-  : m_type(BlockType::Vacant), m_colour(sf::Color::Green), m_arr(sf::LinesStrip, 5) {
-    set_colour(m_colour);
-  }
+static constexpr float spawn_seconds = 5.0f;
+
+// How often events are polled while nothing else is due in OnChange mode.
+static constexpr auto idle_poll = std::chrono::milliseconds(16);
+
+static void usage(char const *name) {
+  std::cerr << "usage: " << name
+            << " [--tick-rate HZ] [--render vsync|capped|on-change] [--fps N] [--record PATH]"
+            << " [--autopilot] [--size WxH] [--grid shader|vertices] [--seed N]\n"
+            << "       [--peer HOST:PORT]... [--player N] [--delay TICKS] [--broadcast PORT]\n"
+            << "       [--watch HOST:PORT] [--metrics PORT] [--stats SECONDS]\n"
+            << "with --peer once for every player, us included, plays over the network\n"
+            << "with --record, later games go to PATH.1, PATH.2 and on after the first\n"
+            << "press F2 in game to toggle the autopilot, F3 for the profiling overlay\n"
+            << "and space once it is over for a new game\n";
+}
 
-  sf::Vector2f position() const noexcept { return m_arr[0].position; }
-  BlockType type() const noexcept { return m_type; }
-  sf::Color colour() const noexcept { return m_colour; }
+// Only goes to the window system when the title actually changes.
+class Title {
+  sf::Window &window;
+  std::string current = title;
 
-  void set_position(sf::Vector2f pos) noexcept {
-    m_arr[0].position = pos;
-    m_arr[1].position = sf::Vector2f(pos.x + block_len, pos.y);
-    m_arr[2].position = pos + sf::Vector2f(block_len, block_len);
-    m_arr[3].position = sf::Vector2f(pos.x, pos.y + block_len);
-    m_arr[4].position = pos;
-  }
+public:
+  explicit Title(sf::Window &window) : window(window) {}
 
-  void set_colour(sf::Color colour) noexcept {
-    for (std::size_t i = 0; i < m_arr.getVertexCount(); i++) {
-      m_arr[i].color = colour;
+  void set(std::string const &message) {
+    auto next = std::string(title) + " : " + message;
+    if (next != current) {
+      current = std::move(next);
+      window.setTitle(current);
     }
   }
-
-  void set_type(BlockType type) noexcept {
-    switch (type) {
-    case BlockType::Vacant:
-      m_arr.setPrimitiveType(sf::LinesStrip);
-      break;
-    case BlockType::OccupiedSnake:
-    case BlockType::OccupiedFruit:
-      m_arr.setPrimitiveType(sf::Quads);
-      break;
-    }
-
-    m_type = type;
-  }
-
-  void draw(sf::RenderTarget &target, sf::RenderStates states) const override {
-    target.draw(m_arr, states);
-  }
 };
 
-class Grid : public sf::Drawable {
-  std::size_t _horizontal, _vertical;
-  std::vector<Block> blocks;
+static bool parse_options(int argc, char **argv, Options &options) {
+  for (int i = 1; i < argc; i++) {
+    auto arg = argv[i];
+    auto value = i + 1 < argc ? argv[i + 1] : nullptr;
 
-public:
-  Grid(std::size_t horizontal, std::size_t vertical, sf::Vector2f pos, sf::Vector2u resolution)
-    : _horizontal(horizontal), _vertical(vertical), blocks(horizontal * vertical) {
+    if (std::strcmp(arg, "--autopilot") == 0) {
+      options.autopilot = true;
+      continue;
+    }
 
-    const std::size_t max_blocks_horizontal =
-      std::floor(float(resolution.x - pos.x) / block_len);
-    const auto max_blocks_vertical =
-      std::size_t(std::floor(float(resolution.y - pos.y) / block_len));
+    if (value == nullptr) {
+      return false;
+    }
 
-    const float first_x = pos.x;
+    if (std::strcmp(arg, "--tick-rate") == 0) {
+      options.tick_rate = std::strtof(value, nullptr);
+      if (!(options.tick_rate > 0.0f)) {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--fps") == 0) {
+      options.fps = unsigned(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--size") == 0) {
+      char *end = nullptr;
+      options.horizontal = std::strtoul(value, &end, 10);
+      if (*end != 'x') {
+        return false;
+      }
 
-    for (std::size_t x = 0, y = 0; y < std::min(max_blocks_vertical, vertical); y++) {
-      for (; x < std::min(max_blocks_horizontal, horizontal); x++) {
-        auto& block = blocks[x + y * horizontal];
-        block.set_position(pos);
+      options.vertical = std::strtoul(end + 1, &end, 10);
+      if (*end != '\0' || options.horizontal == 0 || options.vertical == 0) {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--seed") == 0) {
+      options.seed = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--peer") == 0) {
+      options.peers.push_back(value);
+    } else if (std::strcmp(arg, "--player") == 0) {
+      options.player = std::strtoul(value, nullptr, 10);
+    } else if (std::strcmp(arg, "--delay") == 0) {
+      options.delay = std::uint32_t(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(arg, "--broadcast") == 0) {
+      auto port = std::strtoul(value, nullptr, 10);
+      if (port == 0 || port > 0xFFFF) {
+        return false;
+      }
 
-        pos.x += block_len;
+      options.broadcast = static_cast<unsigned short>(port);
+    } else if (std::strcmp(arg, "--metrics") == 0) {
+      auto port = std::strtoul(value, nullptr, 10);
+      if (port == 0 || port > 0xFFFF) {
+        return false;
       }
 
-      x = 0;
-      pos.x = first_x;
-      pos.y += block_len;
+      options.metrics = static_cast<unsigned short>(port);
+    } else if (std::strcmp(arg, "--stats") == 0) {
+      options.stats_seconds = std::strtof(value, nullptr);
+      if (!(options.stats_seconds > 0.0f)) {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--watch") == 0) {
+      options.watch = value;
+    } else if (std::strcmp(arg, "--record") == 0) {
+      options.record = value;
+    } else if (std::strcmp(arg, "--grid") == 0) {
+      if (std::strcmp(value, "shader") == 0) {
+        options.grid = GridMode::Shader;
+      } else if (std::strcmp(value, "vertices") == 0) {
+        options.grid = GridMode::Vertices;
+      } else {
+        return false;
+      }
+    } else if (std::strcmp(arg, "--render") == 0) {
+      if (std::strcmp(value, "vsync") == 0) {
+        options.render = RenderMode::VSync;
+      } else if (std::strcmp(value, "capped") == 0) {
+        options.render = RenderMode::Capped;
+      } else if (std::strcmp(value, "on-change") == 0) {
+        options.render = RenderMode::OnChange;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
     }
-  }
 
-  void draw(sf::RenderTarget &target, sf::RenderStates states) const override {
-    for (const auto &block : blocks) {
-      target.draw(block, states);
-    }
+    i++;
   }
 
-  std::size_t horizontal() const noexcept { return _horizontal; }
-  std::size_t vertical() const noexcept { return _vertical; }
-  std::size_t len() const noexcept { return blocks.size(); }
-
-  Block &operator[](sf::Vector2u pos) { return blocks[pos.x + pos.y * horizontal()]; }
-  const Block &operator[](sf::Vector2u pos) const { return blocks[pos.x + pos.y * horizontal()]; }
-
-  Block &operator[](std::size_t pos) noexcept { return blocks[pos]; }
-  const Block &operator[](std::size_t pos) const noexcept { return blocks[pos]; }
-};
-
-sf::Vector2u operator+(sf::Vector2u lhs, sf::Vector2i rhs) {
-  return sf::Vector2u(uint(int(lhs.x) + rhs.x), uint(int(lhs.y) + rhs.y));
+  return true;
 }
 
-enum class Direction : uint8_t {
-  None,
-  Left,
-  Right,
-  Up,
-  Down,
-};
+int main(int argc, char **argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    usage(argv[0]);
+    return 1;
+  }
 
-sf::Vector2i to_pos(Direction direction) {
-  int x = 0;
-  int y = 0;
+  sf::RenderWindow window(sf::VideoMode(500, 400), "Snek");
 
-  switch (direction) {
-  case Direction::Left:
-    x = -1;
-    break;
-  case Direction::Right:
-    x = 1;
-    break;
-  case Direction::Up:
-    y = -1;
+  switch (options.render) {
+  case RenderMode::VSync:
+    window.setVerticalSyncEnabled(true);
     break;
-  case Direction::Down:
-    y = 1;
+  case RenderMode::Capped:
+    window.setFramerateLimit(options.fps);
     break;
-  default:
+  case RenderMode::OnChange:
     break;
   }
 
-  return sf::Vector2i(x, y);
-}
-
-struct MotorException : public std::exception {
-  const char *what() const noexcept override { return "cannot turn the opposite direction"; }
-};
-
-struct CollisionException : public std::exception {
-  const char *what() const noexcept override { return "collided with the snake's own body"; }
-};
-
-namespace randomiser {
-  static std::random_device source;
-  static std::mt19937 generator(source());
-
-  std::size_t gen(std::size_t min, std::size_t max) {
-    auto dist = std::uniform_int_distribution<std::size_t>(min, max);
-    return dist(generator);
-  }
-} // namespace randomiser
-
-class Snake {
-  Grid &grid;
-
-  sf::Vector2u head_position;
-  std::vector<sf::Vector2u> body_positions;
+  auto spawn_interval = std::uint32_t(std::lround(spawn_seconds * options.tick_rate));
 
-  Direction _direction;
+  auto seed = options.seed ? *options.seed : std::uint64_t(std::random_device()());
 
-  void assert(sf::Vector2u pos) const {
-    if (pos.x >= grid.horizontal())
-      throw std::out_of_range("cannot move outside the grid horizontally");
-    if (pos.y >= grid.vertical())
-      throw std::out_of_range("cannot move outside the grid vertically");
-
-    if (grid[pos].type() == BlockType::OccupiedSnake)
-      throw CollisionException();
+  if (options.watch != nullptr) {
+    return watch(window, options.watch);
   }
 
-  void assert_direction(Direction direct) const {
-    if ((direct == Direction::Left && _direction == Direction::Right) ||
-        (direct == Direction::Right && _direction == Direction::Left)) {
-      throw MotorException();
+  if (!options.peers.empty()) {
+    NetGame game;
+    game.peers = options.peers;
+    game.player = options.player;
+    game.seed = seed;
+    game.horizontal = options.horizontal;
+    game.vertical = options.vertical;
+    game.tick_rate = options.tick_rate;
+    game.spawn_interval = spawn_interval;
+    game.delay = options.delay;
+
+    try {
+      return play_networked(window, game);
+    } catch (std::invalid_argument const &ex) {
+      std::cerr << ex.what() << "\n";
+      return 1;
     }
+  }
 
-    if ((direct == Direction::Up && _direction == Direction::Down) ||
-        (direct == Direction::Down && _direction == Direction::Up)) {
-      throw MotorException();
+  SnakeSim sim(options.horizontal, options.vertical, seed, spawn_interval);
+  sim.time_spawns(true);
+  auto board_pos = sf::Vector2f(12.0f, 8.0f);
+
+  // Either draws the whole board, and only the one in use is ever built.
+  // Both live as long as the window, so a new game reuses what is already
+  // on the GPU rather than compiling and uploading it all again.
+  std::optional<ShaderGrid> shaded;
+  if (options.grid == GridMode::Shader) {
+    try {
+      shaded.emplace(sim.board(), board_pos);
+    } catch (std::runtime_error const &ex) {
+      std::cerr << ex.what() << "; drawing the grid with vertices\n";
     }
   }
 
-  void update_pos(sf::Vector2u &pos, sf::Vector2u new_pos) {
-    grid[pos].set_type(BlockType::Vacant);
-
-    pos = new_pos;
-
-    grid[pos].set_type(BlockType::OccupiedSnake);
+  std::optional<Grid> grid;
+  if (!shaded) {
+    grid.emplace(sim.board(), board_pos);
   }
 
-public:
-  Snake(Grid &grid) : grid(grid), head_position(), body_positions(), _direction(Direction::None) {
-    auto horizontal = randomiser::gen(0, grid.horizontal());
-    auto vertical = randomiser::gen(0, grid.vertical());
-    auto initial = sf::Vector2u(horizontal, vertical);
+  const sf::Drawable &board_view = shaded ? static_cast<const sf::Drawable &>(*shaded) : *grid;
+  Hud hud;
+  Title window_title(window);
 
-    grid[initial].set_type(BlockType::OccupiedSnake);
+  Autopilot pilot(sim.board());
+  bool piloting = options.autopilot;
 
-    head_position = std::move(initial);
+  std::optional<ReplayWriter> recorder;
+  if (options.record != nullptr) {
+    recorder.emplace(sim, seed);
   }
 
-  void move() {
-    auto pos = to_pos(_direction);
-
-    auto old_pos = head_position;
-    auto new_pos = head_position + pos;
-
-    assert(new_pos);
-
-    bool was_occupied_by_fruit = grid[new_pos].type() == BlockType::OccupiedFruit;
-
-    update_pos(head_position, new_pos);
-
-    for (auto &pos : body_positions) {
-      auto before = pos;
-
-      update_pos(pos, old_pos);
-
-      old_pos = before;
+  // Writes the replay of the game being recorded to the next file in turn.
+  std::size_t replays_saved = 0;
+  auto save_replay = [&] {
+    std::string path = options.record;
+    if (replays_saved != 0) {
+      path += "." + std::to_string(replays_saved);
     }
 
-    if (was_occupied_by_fruit) {
-      grid[new_pos].set_colour(sf::Color::Green);
+    replays_saved++;
 
-      add_body();
+    if (!recorder->save(path.c_str())) {
+      std::cerr << "could not write the replay to " << path << "\n";
+      return false;
     }
-  }
 
-  Direction direction() const noexcept { return _direction; }
-
-  void set_direction(Direction direct) {
-    assert_direction(direct);
+    return true;
+  };
+
+  // Spectators see each tick as it is played.
+  SpectatorEncoder encoder(sim.board());
+  std::optional<Broadcast> broadcast;
+  if (options.broadcast != 0) {
+    try {
+      broadcast.emplace(options.broadcast);
+    } catch (std::runtime_error const &ex) {
+      std::cerr << ex.what() << "\n";
+      return 1;
+    }
 
-    _direction = direct;
+    broadcast->publish(encoder.encode(sim.board(), sim.ticks()));
   }
 
-  void add_body() {
-    auto tail = body_positions.empty() ? head_position : body_positions.back();
-
-    switch (_direction) {
-    case Direction::Left:
-      tail.x += 1;
-      break;
-    case Direction::Right:
-      tail.x -= 1;
-      break;
-    case Direction::Up:
-      tail.y += 1;
-      break;
-    case Direction::Down:
-      tail.y -= 1;
-      break;
-    default:
-      break;
+  std::optional<MetricsEndpoint> metrics_endpoint;
+  if (options.metrics != 0) {
+    try {
+      metrics_endpoint.emplace(options.metrics);
+    } catch (std::runtime_error const &ex) {
+      std::cerr << ex.what() << "\n";
+      return 1;
     }
+  }
 
-    grid[tail].set_type(BlockType::OccupiedSnake);
+  auto stats_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<float>(options.stats_seconds));
+  auto next_stats = std::chrono::steady_clock::now() + stats_interval;
 
-    body_positions.emplace_back(std::move(tail));
-  }
-};
+  // Key presses wait here until a tick takes them, so quick presses between
+  // ticks each get a tick of their own.
+  InputQueue input;
 
-static sf::Color fruit_colours[] = {
-  sf::Color::Red, sf::Color::Blue, sf::Color(0xFF, 0xA5, 0x00), // Orange
-};
+  // Turns the snake, noting the turn in the replay if it took.
+  auto turn = [&](Direction direct) {
+    sim.set_direction(direct);
 
-static sf::Color gen_fruit_colour() {
-  return fruit_colours[randomiser::gen(0, 3)];
-}
+    if (recorder) {
+      recorder->turn(sim.ticks(), direct);
+    }
+  };
 
-static Block& get_block_randomly(Grid &grid) {
-  std::size_t pos = 0;
+  // The autopilot's turns go through turn() too, so replays include them.
+  auto steer = [&] {
+    auto direct = pilot.steer(sim);
+    if (direct != sim.direction()) {
+      turn(direct);
+    }
+  };
 
-  do {
-    pos = randomiser::gen(0, grid.len() - 1);
-  } while (is_occupied(grid[pos].type()));
+  auto state = GameStates::Start;
 
-  return grid[pos];
-}
+  // Starts over in place once a game is over: the board, the snake and
+  // whatever draws them are all kept and only cleared, so a new game costs a
+  // pass over the board rather than a fresh start of the program.
+  auto new_game = [&] {
+    SNEK_TRACE_ZONE("new game");
 
-static void spawn_fruit(Grid &grid) {
-  auto& block = get_block_randomly(grid);
+    if (!options.seed) {
+      seed = std::uint64_t(std::random_device()());
+    }
 
-  block.set_type(BlockType::OccupiedFruit);
-  block.set_colour(gen_fruit_colour());
-}
+    // The game just over keeps its replay; a failed write is reported and
+    // play carries on.
+    if (recorder) {
+      save_replay();
+    }
 
-static char const *title = "Snek";
+    sim.restart(seed, spawn_interval);
+    input.clear();
 
-enum class GameStates : uint8_t {
-  Start,
-  InProgress,
-  End,
-};
+    if (recorder) {
+      recorder.emplace(sim, seed);
+    }
 
-int main() {
-  sf::RenderWindow window(sf::VideoMode(500, 400), "Snek");
+    if (broadcast) {
+      broadcast->publish(encoder.encode(sim.board(), sim.ticks()));
+    }
 
-  Grid grid(19, 15, sf::Vector2f(12.0f, 8.0f), window.getSize());
-  Snake snake(grid);
+    window_title.set("new game");
+    state = GameStates::Start;
+  };
 
-  auto state = GameStates::Start;
+  FixedTimestep timestep(std::chrono::duration_cast<FixedTimestep::clock::duration>(
+    std::chrono::duration<float>(1.0f / options.tick_rate)));
 
-  sf::Clock clock;
+  bool redraw = true;
+  sf::Clock frame_clock;
+  sf::View camera = window.getDefaultView();
 
-  auto movement_seconds = 0.0f;
-  auto spawn_seconds = 0.0f;
+#ifdef SNEK_TRACING
+  // F4 and quitting both write the trace here.
+  const char *trace_path = std::getenv("SNEK_TRACE_FILE");
+  if (trace_path == nullptr) {
+    trace_path = "snek-trace.json";
+  }
+#endif
 
   while (window.isOpen()) {
-    auto event = sf::Event();
-    while (window.pollEvent(event)) {
-      switch (event.type) {
-      case sf::Event::Closed:
-        window.close();
-        break;
-      case sf::Event::KeyPressed:
-        try {
+    {
+      SNEK_TRACE_ZONE("poll events");
+
+      auto event = sf::Event();
+      while (window.pollEvent(event)) {
+        switch (event.type) {
+        case sf::Event::Closed:
+          window.close();
+          break;
+        case sf::Event::KeyPressed:
           switch (event.key.code) {
           case sf::Keyboard::Left:
-            snake.set_direction(Direction::Left);
+            input.push(Direction::Left);
             break;
           case sf::Keyboard::Right:
-            snake.set_direction(Direction::Right);
+            input.push(Direction::Right);
             break;
           case sf::Keyboard::Up:
-            snake.set_direction(Direction::Up);
+            input.push(Direction::Up);
             break;
           case sf::Keyboard::Down:
-            snake.set_direction(Direction::Down);
+            input.push(Direction::Down);
+            break;
+          case sf::Keyboard::Space:
+            if (state == GameStates::End) {
+              new_game();
+            }
+
+            break;
+          case sf::Keyboard::F2:
+            piloting = !piloting;
+            break;
+          case sf::Keyboard::F3:
+            hud.toggle();
             break;
+#ifdef SNEK_TRACING
+          case sf::Keyboard::F4:
+            if (!trace::dump(trace_path)) {
+              window_title.set("could not write the trace");
+            }
+
+            break;
+#endif
           default:
             break;
           }
-        } catch (MotorException const &ex) {
-          window.setTitle(sf::String(title) + " : " + ex.what());
+
+          break;
+        default:
+          break;
         }
 
-        break;
-      default:
-        break;
+        redraw = true;
       }
     }
 
     switch (state) {
     case GameStates::Start:
-      if (snake.direction() != Direction::None) {
+      if (auto direct = input.take(sim.direction(), FixedTimestep::clock::now());
+          direct != Direction::None) {
+        turn(direct);
+      }
+
+      if (piloting) {
+        steer();
+      }
+
+      if (sim.direction() != Direction::None) {
         state = GameStates::InProgress;
+        timestep.reset();
+        metrics::add(metrics::Counter::GamesStarted);
       }
 
       break;
     case GameStates::InProgress: {
-      float secs = clock.restart().asSeconds();
+      for (auto due = timestep.advance(); due > 0 && state == GameStates::InProgress; due--) {
+        SNEK_TRACE_ZONE("tick");
+        auto tick_start = std::chrono::steady_clock::now();
+        auto allocations = metrics::thread_allocations();
+
+        // One turn a tick, out of those pressed before the tick fell due.
+        InputQueue::clock::time_point pressed;
+        if (auto direct = input.take(sim.direction(), timestep.due_at(due), &pressed);
+            direct != Direction::None) {
+          turn(direct);
+          metrics::observe(metrics::Histogram::InputLatency, tick_start - pressed);
+        }
 
-      movement_seconds += secs;
-      spawn_seconds += secs;
+        if (piloting) {
+          steer();
+        }
 
-      if (spawn_seconds >= 5.0f) {
-        spawn_fruit(grid);
+        auto fruits = sim.board().fruit_len();
+        auto len = sim.snake().len();
 
-        spawn_seconds = 0.0f;
-      }
-
-      if (movement_seconds >= 0.25f) {
+        auto result = MoveResult::Ok;
         try {
-          snake.move();
+          sim.tick();
         } catch (std::out_of_range const &ex) {
-          window.setTitle(sf::String(title) + " : " + ex.what() + "- over!");
+          window_title.set(std::string(ex.what()) + "- over!");
           state = GameStates::End;
+          result = MoveResult::HitWall;
+          metrics::add(metrics::Counter::GamesEndedWall);
         } catch (CollisionException const &ex) {
-          window.setTitle(sf::String(title) + " : " + ex.what() + "- over!");
+          window_title.set(std::string(ex.what()) + "- over!");
           state = GameStates::End;
+          result = MoveResult::HitSelf;
+          metrics::add(metrics::Counter::GamesEndedSelf);
+        }
+
+        // A fruit eaten this tick was there before it too.
+        auto spawned = sim.board().fruit_len() + (sim.snake().len() - len) - fruits;
+
+        if (recorder) {
+          recorder->tick(sim, result);
         }
 
-        movement_seconds = 0.0f;
+        if (broadcast) {
+          broadcast->publish(encoder.encode(sim.board(), sim.ticks()));
+        }
+
+        auto tick_time = std::chrono::steady_clock::now() - tick_start;
+        hud.record_tick(std::chrono::duration<float>(tick_time).count());
+
+        auto allocated = metrics::thread_allocations() - allocations;
+        metrics::add(metrics::Counter::Ticks);
+        metrics::add(metrics::Counter::Allocations, allocated);
+        metrics::observe(metrics::Histogram::TickTime, tick_time);
+        metrics::observe(metrics::Histogram::TickAllocations, allocated);
+
+        if (spawned != 0) {
+          metrics::add(metrics::Counter::FruitSpawned, spawned);
+        }
+
+        if (sim.board().vacant_len() == 0) {
+          window_title.set("no room left for fruit");
+        }
+
+        redraw = true;
       }
 
       break;
@@ -402,9 +546,92 @@ int main() {
       break;
     }
 
-    window.clear(sf::Color::White);
-    window.draw(grid);
-    window.display();
+    if (!window.isOpen()) {
+      break;
+    }
+
+    if (broadcast) {
+      broadcast->poll(encoder);
+    }
+
+    if (metrics_endpoint) {
+      metrics_endpoint->poll();
+    }
+
+    if (options.stats_seconds > 0.0f && std::chrono::steady_clock::now() >= next_stats) {
+      std::cerr << metrics::text();
+      next_stats += stats_interval;
+    }
+
+    // Vsynced and capped frames are paced by display() itself; in OnChange
+    // mode nothing is drawn until something moved, unless the overlay is up.
+    if (redraw || hud.shown() || options.render != RenderMode::OnChange) {
+      {
+        SNEK_TRACE_ZONE("sync");
+        auto size = sf::Vector2f(window.getSize());
+        if (shaded) {
+          camera = shaded->camera(size, sim.snake().head());
+          shaded->sync();
+        } else {
+          camera = grid->camera(size, sim.snake().head());
+          grid->sync(camera);
+        }
+
+        hud.update();
+      }
+
+      {
+        SNEK_TRACE_ZONE("clear");
+        window.clear(sf::Color::White);
+      }
+
+      {
+        SNEK_TRACE_ZONE("draw");
+        // The board scrolls with the head; the overlay stays put.
+        window.setView(camera);
+        window.draw(board_view);
+        window.setView(window.getDefaultView());
+        window.draw(hud);
+      }
+
+      {
+        SNEK_TRACE_ZONE("display");
+        window.display();
+      }
+
+      auto draws = shaded ? 1u : unsigned(grid->visible_chunks());
+      auto uploaded = shaded ? shaded->uploaded_bytes()
+                             : grid->uploaded_vertices() * sizeof(sf::Vertex);
+      auto frame_time = frame_clock.restart();
+      hud.record_frame(frame_time.asSeconds(), draws + (hud.shown() ? 1 : 0), uploaded);
+      metrics::observe(metrics::Histogram::FrameTime,
+                       std::chrono::microseconds(frame_time.asMicroseconds()));
+
+      redraw = false;
+    }
+
+    if (options.render == RenderMode::OnChange) {
+      auto idle = idle_poll;
+      if (state == GameStates::InProgress) {
+        idle = std::min(idle, std::chrono::duration_cast<std::chrono::milliseconds>(
+                                timestep.until_next()));
+      }
+
+      SNEK_TRACE_ZONE("sleep");
+      sf::sleep(sf::milliseconds(std::int32_t(idle.count())));
+    }
+  }
+
+  if (state == GameStates::InProgress) {
+    metrics::add(metrics::Counter::GamesEndedQuit);
+  }
+
+#ifdef SNEK_TRACING
+  trace::dump(trace_path);
+#endif
+
+  if (recorder && !save_replay()) {
+    return 1;
   }
 
   return 0;
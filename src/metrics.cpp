@@ -0,0 +1,160 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+  // Only the owning thread writes a shard, so a load and a store do what an
+  // atomic increment would without its cost; read() may load at any time.
+  struct alignas(64) Shard {
+    struct Buckets {
+      std::atomic<std::uint64_t> counts[bucket_count] = {};
+      std::atomic<std::uint64_t> sum{0};
+    };
+
+    std::atomic<std::uint64_t> counters[counter_count] = {};
+    Buckets histograms[histogram_count];
+  };
+
+  static void bump(std::atomic<std::uint64_t> &value, std::uint64_t by) noexcept {
+    value.store(value.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+  }
+
+  // Shards outlive their threads, so what a finished thread counted still adds up.
+  static std::mutex registry_mutex;
+  static std::vector<std::unique_ptr<Shard>> registry;
+
+  static Shard &local_shard() {
+    thread_local Shard *shard = [] {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      registry.push_back(std::make_unique<Shard>());
+      return registry.back().get();
+    }();
+
+    return *shard;
+  }
+
+  static thread_local std::uint64_t allocations = 0;
+
+  std::uint64_t thread_allocations() noexcept { return allocations; }
+  void count_allocation() noexcept { allocations++; }
+
+  void add(Counter counter, std::uint64_t by) noexcept {
+    bump(local_shard().counters[std::size_t(counter)], by);
+  }
+
+  void observe(Histogram histogram, std::uint64_t value) noexcept {
+    auto &buckets = local_shard().histograms[std::size_t(histogram)];
+
+    // The smallest k with value <= 2^k.
+    std::size_t bucket = value <= 1 ? 0 : std::size_t(64 - __builtin_clzll(value - 1));
+    if (bucket >= bucket_count) {
+      bucket = bucket_count - 1;
+    }
+
+    bump(buckets.counts[bucket], 1);
+    bump(buckets.sum, value);
+  }
+
+  Totals read() {
+    Totals totals;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    for (auto &shard : registry) {
+      for (std::size_t i = 0; i < counter_count; i++) {
+        totals.counters[i] += shard->counters[i].load(std::memory_order_relaxed);
+      }
+
+      for (std::size_t i = 0; i < histogram_count; i++) {
+        auto &from = shard->histograms[i];
+        auto &to = totals.histograms[i];
+
+        for (std::size_t bucket = 0; bucket < bucket_count; bucket++) {
+          auto count = from.counts[bucket].load(std::memory_order_relaxed);
+          to.counts[bucket] += count;
+          to.count += count;
+        }
+
+        to.sum += from.sum.load(std::memory_order_relaxed);
+      }
+    }
+
+    return totals;
+  }
+
+  static void append(std::string &out, const char *format, ...) {
+    char line[256];
+
+    va_list args;
+    va_start(args, format);
+    auto len = std::vsnprintf(line, sizeof line, format, args);
+    va_end(args);
+
+    out.append(line, std::size_t(std::max(0, std::min(len, int(sizeof line) - 1))));
+  }
+
+  static void append_counter(std::string &out, const char *name, const char *help,
+                             std::uint64_t value) {
+    append(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name,
+           static_cast<unsigned long long>(value));
+  }
+
+  // Buckets are cumulative in the exposition format, and `scale` turns
+  // recorded units into shown ones.
+  static void append_histogram(std::string &out, const char *name, const char *help,
+                               const Totals::Buckets &buckets, double scale) {
+    append(out, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+
+    std::uint64_t below = 0;
+    for (std::size_t bucket = 0; bucket + 1 < bucket_count; bucket++) {
+      below += buckets.counts[bucket];
+      append(out, "%s_bucket{le=\"%g\"} %llu\n", name, double(std::uint64_t(1) << bucket) * scale,
+             static_cast<unsigned long long>(below));
+    }
+
+    append(out, "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %g\n%s_count %llu\n", name,
+           static_cast<unsigned long long>(buckets.count), name, double(buckets.sum) * scale,
+           name, static_cast<unsigned long long>(buckets.count));
+  }
+
+  std::string text() {
+    auto totals = read();
+    std::string out;
+
+    append_counter(out, "snek_ticks_total", "Ticks played.", totals[Counter::Ticks]);
+    append_counter(out, "snek_games_started_total", "Games started.",
+                   totals[Counter::GamesStarted]);
+
+    append(out, "# HELP snek_games_ended_total Games ended, by how.\n"
+                "# TYPE snek_games_ended_total counter\n");
+    append(out, "snek_games_ended_total{cause=\"wall\"} %llu\n",
+           static_cast<unsigned long long>(totals[Counter::GamesEndedWall]));
+    append(out, "snek_games_ended_total{cause=\"self\"} %llu\n",
+           static_cast<unsigned long long>(totals[Counter::GamesEndedSelf]));
+    append(out, "snek_games_ended_total{cause=\"quit\"} %llu\n",
+           static_cast<unsigned long long>(totals[Counter::GamesEndedQuit]));
+
+    append_counter(out, "snek_fruit_spawned_total", "Fruit spawned.",
+                   totals[Counter::FruitSpawned]);
+    append_counter(out, "snek_tick_allocations_total", "Heap allocations made while ticking.",
+                   totals[Counter::Allocations]);
+
+    append_histogram(out, "snek_tick_seconds", "Time a tick took.", totals[Histogram::TickTime],
+                     1e-9);
+    append_histogram(out, "snek_frame_seconds", "Time from one frame to the next.",
+                     totals[Histogram::FrameTime], 1e-9);
+    append_histogram(out, "snek_input_latency_seconds",
+                     "Time from a key press to the tick that moved on it.",
+                     totals[Histogram::InputLatency], 1e-9);
+    append_histogram(out, "snek_spawn_seconds", "Time spawning a fruit took.",
+                     totals[Histogram::SpawnTime], 1e-9);
+    append_histogram(out, "snek_tick_allocations", "Heap allocations made in one tick.",
+                     totals[Histogram::TickAllocations], 1.0);
+
+    return out;
+  }
+} // namespace metrics
@@ -0,0 +1,97 @@
+#pragma once
+
+// Always-on counters and histograms for watching games across a fleet.
+// Every thread counts into a shard of its own with plain relaxed stores, so
+// counting costs about as much as an increment and never contends; read()
+// adds the shards up. text() renders them in the Prometheus text exposition
+// format, for an endpoint to serve or a log to take.
+//
+// Histograms count values into power-of-two buckets: bucket `k` holds
+// values up to 2^k, the last everything larger. Times are recorded in
+// nanoseconds and shown in seconds.
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace metrics {
+  enum class Counter : std::uint8_t {
+    Ticks,
+    GamesStarted,
+    // One for each way a game ends.
+    GamesEndedWall,
+    GamesEndedSelf,
+    GamesEndedQuit,
+    FruitSpawned,
+    Allocations,
+  };
+
+  static constexpr std::size_t counter_count = 7;
+
+  enum class Histogram : std::uint8_t {
+    // Nanoseconds.
+    TickTime,
+    FrameTime,
+    InputLatency,
+    SpawnTime,
+    // Allocations.
+    TickAllocations,
+  };
+
+  static constexpr std::size_t histogram_count = 5;
+  static constexpr std::size_t bucket_count = 33;
+
+  struct Totals {
+    struct Buckets {
+      std::uint64_t counts[bucket_count] = {};
+      std::uint64_t sum = 0, count = 0;
+    };
+
+    std::uint64_t counters[counter_count] = {};
+    Buckets histograms[histogram_count];
+
+    std::uint64_t operator[](Counter counter) const noexcept {
+      return counters[std::size_t(counter)];
+    }
+
+    const Buckets &operator[](Histogram histogram) const noexcept {
+      return histograms[std::size_t(histogram)];
+    }
+  };
+
+  void add(Counter counter, std::uint64_t by = 1) noexcept;
+  void observe(Histogram histogram, std::uint64_t value) noexcept;
+
+  template <typename Rep, typename Period>
+  void observe(Histogram histogram, std::chrono::duration<Rep, Period> time) noexcept {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+    observe(histogram, ns > 0 ? std::uint64_t(ns) : 0);
+  }
+
+  // Every thread's counts so far, added up. Safe to call while others count.
+  Totals read();
+
+  // read() in the Prometheus text exposition format.
+  std::string text();
+
+  // How many times the calling thread has allocated. Only programs that
+  // link count_allocations.cpp count them; elsewhere this stays zero.
+  std::uint64_t thread_allocations() noexcept;
+  void count_allocation() noexcept;
+
+  // Times a scope into `histogram`.
+  class Timer {
+    Histogram histogram;
+    std::chrono::steady_clock::time_point begin;
+
+  public:
+    explicit Timer(Histogram histogram) noexcept
+      : histogram(histogram), begin(std::chrono::steady_clock::now()) {}
+    ~Timer() { observe(histogram, std::chrono::steady_clock::now() - begin); }
+
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+  };
+} // namespace metrics
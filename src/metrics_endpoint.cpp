@@ -0,0 +1,76 @@
+#include "metrics_endpoint.hpp"
+
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+MetricsEndpoint::MetricsEndpoint(unsigned short port) {
+  if (listener.listen(port) != sf::Socket::Done)
+    throw std::runtime_error("could not listen for metrics on port " + std::to_string(port));
+
+  listener.setBlocking(false);
+}
+
+static std::string respond(const std::string &request) {
+  auto scrape =
+    request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0;
+  auto status = scrape ? "200 OK" : "404 Not Found";
+  auto body = scrape ? metrics::text() : std::string("not found\n");
+
+  return std::string("HTTP/1.1 ") + status +
+         "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+         std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+bool MetricsEndpoint::serve(Client &client) {
+  if (client.response.empty()) {
+    char incoming[1024];
+    std::size_t received = 0;
+
+    auto status = sf::Socket::Done;
+    while ((status = client.socket.receive(incoming, sizeof incoming, received)) ==
+           sf::Socket::Done) {
+      client.request.append(incoming, received);
+    }
+
+    if (status == sf::Socket::Disconnected || status == sf::Socket::Error) {
+      return false;
+    }
+
+    if (client.request.find("\r\n\r\n") == std::string::npos) {
+      return client.request.size() <= max_request;
+    }
+
+    client.response = respond(client.request);
+  }
+
+  std::size_t sent = 0;
+  auto status = client.socket.send(client.response.data() + client.sent,
+                                   client.response.size() - client.sent, sent);
+  client.sent += sent;
+
+  if (status == sf::Socket::Disconnected || status == sf::Socket::Error) {
+    return false;
+  }
+
+  return client.sent < client.response.size();
+}
+
+void MetricsEndpoint::poll() {
+  for (;;) {
+    auto joining = std::make_unique<Client>();
+    if (listener.accept(joining->socket) != sf::Socket::Done) {
+      break;
+    }
+
+    joining->socket.setBlocking(false);
+    clients.push_back(std::move(joining));
+  }
+
+  clients.erase(std::remove_if(clients.begin(), clients.end(),
+                               [](const std::unique_ptr<Client> &client) {
+                                 return !serve(*client);
+                               }),
+                clients.end());
+}
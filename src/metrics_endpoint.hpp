@@ -0,0 +1,33 @@
+#pragma once
+
+// Serves metrics::text() over HTTP for Prometheus to scrape, from the game's
+// own loop: poll() does whatever the sockets allow without blocking.
+
+#include <SFML/Network.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class MetricsEndpoint {
+  struct Client {
+    sf::TcpSocket socket;
+    std::string request, response;
+    std::size_t sent = 0;
+  };
+
+  // Requests longer than this are not scrapes, and are dropped.
+  static constexpr std::size_t max_request = 8192;
+
+  sf::TcpListener listener;
+  std::vector<std::unique_ptr<Client>> clients;
+
+  // Reads and answers what it can; false once the client is done with.
+  static bool serve(Client &client);
+
+public:
+  // Listens on `port`; throws std::runtime_error if it cannot.
+  explicit MetricsEndpoint(unsigned short port);
+
+  void poll();
+};
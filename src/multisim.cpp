@@ -0,0 +1,83 @@
+#include "multisim.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+MultiSnakeSim::MultiSnakeSim(std::size_t horizontal, std::size_t vertical, std::size_t players,
+                             std::uint64_t seed, std::uint32_t spawn_interval)
+  : _board(horizontal, vertical), rng(seed), _alive(players, 1),
+    spawn_interval(std::max<std::uint32_t>(1, spawn_interval)) {
+  if (players == 0 || players > _board.len())
+    throw std::invalid_argument("every player needs a block of the board to start on");
+
+  snakes.reserve(players);
+
+  for (std::size_t i = 0; i < players; i++) {
+    auto index = _board.nth_vacant(rng.below(std::uint32_t(_board.vacant_len())));
+    snakes.emplace_back(_board, Position{std::uint32_t(index % horizontal),
+                                         std::uint32_t(index / horizontal)});
+  }
+}
+
+bool MultiSnakeSim::try_set_direction(std::size_t player, Direction direct) noexcept {
+  return alive(player) && snakes[player].try_set_direction(direct);
+}
+
+void MultiSnakeSim::tick() noexcept {
+  if (++_ticks % spawn_interval == 0 && _board.vacant_len() != 0) {
+    auto index = _board.nth_vacant(rng.below(std::uint32_t(_board.vacant_len())));
+
+    _board.set_type(index, BlockType::OccupiedFruit);
+    _board.set_colour(index, std::uint8_t(1 + rng.below(fruit_colours)));
+  }
+
+  for (std::size_t i = 0; i < snakes.size(); i++) {
+    if (!alive(i) || snakes[i].direction() == Direction::None) {
+      continue;
+    }
+
+    if (is_fatal(snakes[i].try_move())) {
+      snakes[i].remove();
+      _alive[i] = 0;
+    }
+  }
+}
+
+std::size_t MultiSnakeSim::alive_count() const noexcept {
+  return std::size_t(std::count(_alive.begin(), _alive.end(), 1));
+}
+
+std::size_t MultiSnakeSim::state_size() const noexcept {
+  return sizeof(_ticks) + sizeof(spawn_interval) + sizeof(Randomiser::State) +
+         _board.state_size() + snakes.size() * (snakes[0].state_size() + 1);
+}
+
+void MultiSnakeSim::save_state(std::uint8_t *buffer) const noexcept {
+  auto saved = rng.save();
+
+  buffer = put_raw(buffer, &_ticks, 1);
+  buffer = put_raw(buffer, &spawn_interval, 1);
+  buffer = put_raw(buffer, &saved, 1);
+  buffer = put_raw(buffer, _alive.data(), _alive.size());
+  buffer = _board.save_state(buffer);
+
+  for (auto &snake : snakes) {
+    buffer = snake.save_state(buffer);
+  }
+}
+
+void MultiSnakeSim::restore_state(const std::uint8_t *buffer) noexcept {
+  Randomiser::State saved;
+
+  buffer = get_raw(buffer, &_ticks, 1);
+  buffer = get_raw(buffer, &spawn_interval, 1);
+  buffer = get_raw(buffer, &saved, 1);
+  buffer = get_raw(buffer, _alive.data(), _alive.size());
+  buffer = _board.restore_state(buffer);
+
+  for (auto &snake : snakes) {
+    buffer = snake.restore_state(buffer);
+  }
+
+  rng.restore(saved);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "randomiser.hpp"
+#include "sim.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One game with a snake for each player on a shared board. Like SnakeSim it
+// counts ticks and draws everything random from its own generator, so every
+// machine that builds it from the same seed and feeds it the same turns
+// plays the same game, bit for bit.
+class MultiSnakeSim {
+  Board _board;
+  Randomiser rng;
+
+  // Every snake refers to `_board`, and is built in place, never moved.
+  std::vector<Snake> snakes;
+  std::vector<std::uint8_t> _alive;
+
+  std::uint32_t _ticks = 0;
+  std::uint32_t spawn_interval;
+
+public:
+  // Each snake starts on a block of its own picked from `seed`, standing
+  // still until its player first turns it.
+  MultiSnakeSim(std::size_t horizontal, std::size_t vertical, std::size_t players,
+                std::uint64_t seed, std::uint32_t spawn_interval = spawn_ticks);
+
+  MultiSnakeSim(const MultiSnakeSim &) = delete;
+  MultiSnakeSim &operator=(const MultiSnakeSim &) = delete;
+
+  // Refuses reversals, and turns for snakes that are out.
+  bool try_set_direction(std::size_t player, Direction direct) noexcept;
+
+  // One step: a fruit if one is due, then every snake that is still in and
+  // moving goes a block, in player order. A snake that runs into a wall or
+  // any snake, its own or another's, is out and leaves the board.
+  void tick() noexcept;
+
+  std::size_t players() const noexcept { return snakes.size(); }
+  bool alive(std::size_t player) const noexcept { return _alive[player] != 0; }
+  std::size_t alive_count() const noexcept;
+
+  std::uint32_t ticks() const noexcept { return _ticks; }
+
+  Board &board() noexcept { return _board; }
+  const Board &board() const noexcept { return _board; }
+  const Snake &snake(std::size_t player) const noexcept { return snakes[player]; }
+
+  // The whole game as state_size() bytes, as SnakeSim::save_state() does it,
+  // so rollback can keep snapshots in buffers allocated up front.
+  std::size_t state_size() const noexcept;
+  void save_state(std::uint8_t *buffer) const noexcept;
+  void restore_state(const std::uint8_t *buffer) noexcept;
+};
@@ -0,0 +1,185 @@
+#include "netplay.hpp"
+
+#include "grid.hpp"
+#include "input_queue.hpp"
+#include "multisim.hpp"
+#include "timestep.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+struct Address {
+  sf::IpAddress host;
+  unsigned short port;
+};
+
+bool parse_address(const char *text, sf::IpAddress &host, unsigned short &port) {
+  auto colon = std::strrchr(text, ':');
+  if (colon == nullptr) {
+    return false;
+  }
+
+  char *end = nullptr;
+  auto number = std::strtoul(colon + 1, &end, 10);
+  if (*end != '\0' || number == 0 || number > 0xFFFF) {
+    return false;
+  }
+
+  host = sf::IpAddress(std::string(text, colon));
+  port = static_cast<unsigned short>(number);
+
+  return host != sf::IpAddress::None;
+}
+
+// Packets go out at least this often while nothing else is happening, so
+// lost ones are made up for and a stalled peer hears from us.
+static constexpr auto resend_interval = std::chrono::milliseconds(30);
+
+int play_networked(sf::RenderWindow &window, const NetGame &game) {
+  std::vector<Address> peers(game.peers.size());
+
+  for (std::size_t i = 0; i < peers.size(); i++) {
+    if (!parse_address(game.peers[i], peers[i].host, peers[i].port)) {
+      std::cerr << "not a HOST:PORT: " << game.peers[i] << "\n";
+      return 1;
+    }
+  }
+
+  if (game.player >= peers.size()) {
+    std::cerr << "player " << game.player << " is not one of the " << peers.size()
+              << " peers\n";
+    return 1;
+  }
+
+  sf::UdpSocket socket;
+  if (socket.bind(peers[game.player].port) != sf::Socket::Done) {
+    std::cerr << "could not listen on port " << peers[game.player].port << "\n";
+    return 1;
+  }
+
+  socket.setBlocking(false);
+
+  MultiSnakeSim sim(game.horizontal, game.vertical, peers.size(), game.seed,
+                    game.spawn_interval);
+  Lockstep lockstep(sim, game.player, game.seed, game.delay);
+
+  Grid grid(sim.board(), sf::Vector2f(12.0f, 8.0f));
+  InputQueue input;
+
+  FixedTimestep timestep(std::chrono::duration_cast<FixedTimestep::clock::duration>(
+    std::chrono::duration<float>(1.0f / game.tick_rate)));
+
+  std::vector<std::uint8_t> outgoing;
+  std::vector<std::uint8_t> incoming(sf::UdpSocket::MaxDatagramSize);
+
+  auto send = [&] {
+    for (std::size_t peer = 0; peer < peers.size(); peer++) {
+      if (peer != game.player) {
+        lockstep.packet(peer, outgoing);
+        socket.send(outgoing.data(), outgoing.size(), peers[peer].host, peers[peer].port);
+      }
+    }
+  };
+
+  auto last_sent = FixedTimestep::clock::now() - resend_interval;
+  std::string title;
+
+  while (window.isOpen()) {
+    auto event = sf::Event();
+    while (window.pollEvent(event)) {
+      if (event.type == sf::Event::Closed) {
+        window.close();
+      } else if (event.type == sf::Event::KeyPressed) {
+        switch (event.key.code) {
+        case sf::Keyboard::Left:
+          input.push(Direction::Left);
+          break;
+        case sf::Keyboard::Right:
+          input.push(Direction::Right);
+          break;
+        case sf::Keyboard::Up:
+          input.push(Direction::Up);
+          break;
+        case sf::Keyboard::Down:
+          input.push(Direction::Down);
+          break;
+        default:
+          break;
+        }
+      }
+    }
+
+    if (!window.isOpen()) {
+      break;
+    }
+
+    std::size_t received = 0;
+    sf::IpAddress sender;
+    unsigned short sender_port = 0;
+
+    while (socket.receive(incoming.data(), incoming.size(), received, sender, sender_port) ==
+           sf::Socket::Done) {
+      lockstep.receive(Span<std::uint8_t>{incoming.data(), received});
+    }
+
+    // Ticks due while stalled are dropped, so the game slows to the pace of
+    // the slowest peer rather than racing to catch up afterwards.
+    bool stalled = false, played = false;
+    for (auto due = timestep.advance(); due > 0 && !stalled; due--) {
+      if (auto direct = input.take(lockstep.heading(), timestep.due_at(due));
+          direct != Direction::None) {
+        lockstep.turn(direct);
+      }
+
+      if (lockstep.advance()) {
+        played = true;
+      } else {
+        stalled = true;
+      }
+    }
+
+    auto now = FixedTimestep::clock::now();
+    if (played || now - last_sent >= resend_interval) {
+      send();
+      last_sent = now;
+    }
+
+    auto next = "player " + std::to_string(game.player + 1) + " of " +
+                std::to_string(peers.size());
+    if (!sim.alive(game.player)) {
+      next += " - out";
+    } else if (stalled) {
+      next += " - waiting for peers";
+    }
+
+    if (next != title) {
+      title = next;
+      window.setTitle("Snek : " + title);
+    }
+
+    auto &me = sim.snake(game.player);
+    auto focus = sim.alive(game.player)
+                   ? me.head()
+                   : Position{std::uint32_t(game.horizontal / 2), std::uint32_t(game.vertical / 2)};
+    auto camera = grid.camera(sf::Vector2f(window.getSize()), focus);
+    grid.sync(camera);
+
+    window.clear(sf::Color::White);
+    window.setView(camera);
+    window.draw(grid);
+    window.display();
+
+    auto idle = std::min(std::chrono::duration_cast<std::chrono::milliseconds>(
+                           timestep.until_next()),
+                         std::chrono::duration_cast<std::chrono::milliseconds>(resend_interval));
+    sf::sleep(sf::milliseconds(std::int32_t(idle.count())));
+  }
+
+  return 0;
+}
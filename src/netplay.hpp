@@ -0,0 +1,32 @@
+#pragma once
+
+// The game's networked mode: a snake for each player on one board, kept in
+// step over UDP by Lockstep.
+
+#include "lockstep.hpp"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Network/IpAddress.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct NetGame {
+  // Every player's HOST:PORT, the local one included, in player order. All
+  // peers must be given the same list, seed and board.
+  std::vector<const char *> peers;
+  std::size_t player = 0;
+
+  std::uint64_t seed = 0;
+  std::size_t horizontal = 19, vertical = 15;
+  float tick_rate = 4.0f;
+  std::uint32_t spawn_interval = 20;
+  std::uint32_t delay = Lockstep::default_delay;
+};
+
+// Splits HOST:PORT, looking the host up; false for anything else.
+bool parse_address(const char *text, sf::IpAddress &host, unsigned short &port);
+
+// Plays `game` in `window` until the window is closed, and returns the exit
+// status for main().
+int play_networked(sf::RenderWindow &window, const NetGame &game);
@@ -0,0 +1,21 @@
+#include "observation.hpp"
+
+template <typename T>
+static void write_board(const Board &board, const Snake &snake, T *out, std::size_t crop) {
+  auto &fruit = board.fruit_bits();
+
+  observation::write_planes<T>(
+    board.horizontal(), board.vertical(), snake.len(), snake.direction(),
+    [&](std::size_t nth) { return snake[nth]; },
+    [&](T *plane) { observation::expand(fruit.words(), board.len(), plane); },
+    [&](std::size_t index) { return fruit.test(index); }, out, crop);
+}
+
+void write_observation(const Board &board, const Snake &snake, float *out, std::size_t crop) {
+  write_board(board, snake, out, crop);
+}
+
+void write_observation(const Board &board, const Snake &snake, std::uint8_t *out,
+                       std::size_t crop) {
+  write_board(board, snake, out, crop);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+// Games as stacks of planes for learning agents, written straight into a
+// buffer the caller owns. Each plane is one value per block, row by row,
+// and the planes of a game follow one another:
+//
+//   Head   the snake's head;
+//   Body   the rest of the snake, brightest next to the head and fading to
+//          the tail, so the way the body moves can be read off one frame;
+//   Fruit  fruit;
+//   Wall   blocks past the edge of the board, which only a crop shows.
+//
+// Float planes hold 1 where set and uint8 planes 255, the body a fraction
+// of that. Either shows the whole board as it lies, or with `crop` a square
+// that many blocks a side around the head, turned so the snake heads up.
+
+#include "sim.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+enum class ObservationPlane : std::uint8_t {
+  Head,
+  Body,
+  Fruit,
+  Wall,
+};
+
+static constexpr std::size_t observation_planes = 4;
+
+// How many values one game's observation takes.
+inline std::size_t observation_size(std::size_t horizontal, std::size_t vertical,
+                                    std::size_t crop = 0) noexcept {
+  return observation_planes * (crop == 0 ? horizontal * vertical : crop * crop);
+}
+
+void write_observation(const Board &board, const Snake &snake, float *out, std::size_t crop = 0);
+void write_observation(const Board &board, const Snake &snake, std::uint8_t *out,
+                       std::size_t crop = 0);
+
+namespace observation {
+
+template <typename T>
+constexpr T on = T(1);
+template <>
+constexpr std::uint8_t on<std::uint8_t> = 255;
+
+// The body's value `nth` segments from the head of `len`.
+template <typename T>
+T age(std::size_t nth, std::size_t len) noexcept {
+  return T(float(len - nth) / float(len) * float(on<T>));
+}
+
+template <>
+inline std::uint8_t age<std::uint8_t>(std::size_t nth, std::size_t len) noexcept {
+  return std::uint8_t(std::max<std::size_t>(1, (len - nth) * 255 / len));
+}
+
+// A byte of a bitboard as its eight values, so a plane is expanded a byte
+// at a time with one eight-wide copy each.
+template <typename T>
+const std::array<std::array<T, 8>, 256> &byte_table() noexcept {
+  static const auto table = [] {
+    std::array<std::array<T, 8>, 256> table{};
+    for (std::size_t byte = 0; byte < 256; byte++) {
+      for (std::size_t bit = 0; bit < 8; bit++) {
+        table[byte][bit] = (byte >> bit) & 1 ? on<T> : T(0);
+      }
+    }
+
+    return table;
+  }();
+
+  return table;
+}
+
+template <typename T>
+void expand(const std::uint64_t *words, std::size_t len, T *out) noexcept {
+  auto &table = byte_table<T>();
+
+  std::size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    std::memcpy(out + i, table[std::uint8_t(words[i / 64] >> (i % 64))].data(), 8 * sizeof(T));
+  }
+
+  for (; i < len; i++) {
+    out[i] = (words[i / 64] >> (i % 64)) & 1 ? on<T> : T(0);
+  }
+}
+
+// Where a block `view` away from the head in the turned crop is on the
+// board, and back.
+inline Offset to_board(Offset view, Direction heading) noexcept {
+  switch (heading) {
+  case Direction::Down:
+    return Offset{-view.x, -view.y};
+  case Direction::Left:
+    return Offset{view.y, -view.x};
+  case Direction::Right:
+    return Offset{-view.y, view.x};
+  default:
+    return view;
+  }
+}
+
+inline Offset to_view(Offset board, Direction heading) noexcept {
+  switch (heading) {
+  case Direction::Down:
+    return Offset{-board.x, -board.y};
+  case Direction::Left:
+    return Offset{-board.y, board.x};
+  case Direction::Right:
+    return Offset{board.y, -board.x};
+  default:
+    return board;
+  }
+}
+
+// One game's planes, from its snake of `len` segments, `segment(nth)` of them
+// counting from the head, and a board `horizontal` by `vertical`. The fruit
+// comes from `fill_fruit(plane)` for the whole board and `is_fruit(index)`
+// for a crop.
+template <typename T, typename Segment, typename FillFruit, typename IsFruit>
+void write_planes(std::size_t horizontal, std::size_t vertical, std::size_t len,
+                  Direction heading, Segment segment, FillFruit fill_fruit, IsFruit is_fruit,
+                  T *out, std::size_t crop) {
+  auto side = crop == 0 ? horizontal * vertical : crop * crop;
+  auto plane = [&](ObservationPlane which) { return out + std::size_t(which) * side; };
+
+  std::fill(out, out + observation_planes * side, T(0));
+
+  if (crop == 0) {
+    if (len != 0) {
+      auto head = segment(0);
+      plane(ObservationPlane::Head)[head.x + head.y * horizontal] = on<T>;
+    }
+
+    auto body = plane(ObservationPlane::Body);
+    for (std::size_t nth = 1; nth < len; nth++) {
+      auto pos = segment(nth);
+      body[pos.x + pos.y * horizontal] = age<T>(nth, len);
+    }
+
+    fill_fruit(plane(ObservationPlane::Fruit));
+    return;
+  }
+
+  auto centre = int(crop / 2);
+  auto head = len != 0 ? segment(0) : Position{};
+
+  if (len != 0) {
+    plane(ObservationPlane::Head)[std::size_t(centre) * (crop + 1)] = on<T>;
+  }
+
+  auto fruit = plane(ObservationPlane::Fruit);
+  auto wall = plane(ObservationPlane::Wall);
+
+  for (std::size_t row = 0; row < crop; row++) {
+    for (std::size_t column = 0; column < crop; column++) {
+      auto at = to_board(Offset{int(column) - centre, int(row) - centre}, heading);
+      auto x = std::uint32_t(std::int64_t(head.x) + at.x);
+      auto y = std::uint32_t(std::int64_t(head.y) + at.y);
+
+      if (x >= horizontal || y >= vertical) {
+        wall[column + row * crop] = on<T>;
+      } else if (is_fruit(x + y * horizontal)) {
+        fruit[column + row * crop] = on<T>;
+      }
+    }
+  }
+
+  auto body = plane(ObservationPlane::Body);
+  for (std::size_t nth = 1; nth < len; nth++) {
+    auto pos = segment(nth);
+    auto at = to_view(Offset{int(pos.x) - int(head.x), int(pos.y) - int(head.y)}, heading);
+    auto column = at.x + centre, row = at.y + centre;
+
+    if (column >= 0 && row >= 0 && column < int(crop) && row < int(crop)) {
+      body[std::size_t(column) + std::size_t(row) * crop] = age<T>(nth, len);
+    }
+  }
+}
+
+} // namespace observation
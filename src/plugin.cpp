@@ -0,0 +1,75 @@
+#include "plugin.hpp"
+
+#include <dlfcn.h>
+#include <stdexcept>
+
+template <typename Fn>
+static Fn lookup(void *handle, const char *symbol) noexcept {
+  return reinterpret_cast<Fn>(dlsym(handle, symbol));
+}
+
+PolicyPlugin::PolicyPlugin(const char *path) : _name(path) {
+  handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr)
+    throw std::runtime_error(std::string("could not load policy: ") + dlerror());
+
+  auto abi = lookup<decltype(&snek_policy_abi)>(handle, "snek_policy_abi");
+  create = lookup<decltype(create)>(handle, "snek_policy_new");
+  steer_fn = lookup<decltype(steer_fn)>(handle, "snek_policy_steer");
+  destroy = lookup<decltype(destroy)>(handle, "snek_policy_free");
+
+  if (abi == nullptr || create == nullptr || steer_fn == nullptr || destroy == nullptr) {
+    dlclose(handle);
+    throw std::runtime_error(_name + " is missing a snek_policy_ function");
+  }
+
+  if (abi() != SNEK_POLICY_ABI) {
+    dlclose(handle);
+    throw std::runtime_error(_name + " was built for another version of snek_policy.h");
+  }
+
+  if (auto name = lookup<decltype(&snek_policy_name)>(handle, "snek_policy_name")) {
+    if (auto given = name()) {
+      _name = given;
+    }
+  }
+}
+
+PolicyPlugin::~PolicyPlugin() {
+  dlclose(handle);
+}
+
+PolicyPlugin::Game::Game(const PolicyPlugin &plugin, std::size_t horizontal,
+                         std::size_t vertical, std::uint64_t seed)
+  : plugin(plugin),
+    policy(plugin.create(std::uint32_t(horizontal), std::uint32_t(vertical), seed)) {
+  if (policy == nullptr)
+    throw std::runtime_error(plugin.name() + " would not play");
+}
+
+PolicyPlugin::Game::~Game() {
+  plugin.destroy(policy);
+}
+
+Direction PolicyPlugin::Game::steer(const SnakeSim &sim) {
+  auto &board = sim.board();
+  auto &snake = sim.snake();
+
+  snek_game game;
+  game.horizontal = std::uint32_t(board.horizontal());
+  game.vertical = std::uint32_t(board.vertical());
+  game.ticks = sim.ticks();
+  game.snake = board.snake_bits().words();
+  game.fruit = board.fruit_bits().words();
+  game.head = std::uint32_t(board.index(snake.head()));
+  game.tail = std::uint32_t(board.index(snake[snake.len() - 1]));
+  game.length = std::uint32_t(snake.len());
+  game.direction = std::uint8_t(snake.direction());
+
+  auto direct = plugin.steer_fn(policy, &game);
+  if (direct > SNEK_DOWN) {
+    return Direction::None;
+  }
+
+  return Direction(direct);
+}
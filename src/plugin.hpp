@@ -0,0 +1,48 @@
+#pragma once
+
+// Controllers loaded from shared libraries through the C ABI in
+// snek_policy.h.
+
+#include "sim.hpp"
+#include "snek_policy.h"
+
+#include <cstdint>
+#include <string>
+
+class PolicyPlugin {
+  void *handle = nullptr;
+  std::string _name;
+
+  decltype(&snek_policy_new) create = nullptr;
+  decltype(&snek_policy_steer) steer_fn = nullptr;
+  decltype(&snek_policy_free) destroy = nullptr;
+
+public:
+  // Loads the policy at `path`. Throws std::runtime_error if it cannot be
+  // loaded, lacks a function or was built against another ABI.
+  explicit PolicyPlugin(const char *path);
+  ~PolicyPlugin();
+
+  PolicyPlugin(const PolicyPlugin &) = delete;
+  PolicyPlugin &operator=(const PolicyPlugin &) = delete;
+
+  const std::string &name() const noexcept { return _name; }
+
+  // One instance, playing one game; freed when it goes.
+  class Game {
+    const PolicyPlugin &plugin;
+    void *policy;
+
+  public:
+    // Throws std::runtime_error if the policy declines to play.
+    Game(const PolicyPlugin &plugin, std::size_t horizontal, std::size_t vertical,
+         std::uint64_t seed);
+    ~Game();
+
+    Game(const Game &) = delete;
+    Game &operator=(const Game &) = delete;
+
+    // The direction to take before the next tick, or None to keep going.
+    Direction steer(const SnakeSim &sim);
+  };
+};
@@ -0,0 +1,126 @@
+#include "pool.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+// More shards than workers leaves something to steal when one falls behind.
+static constexpr std::size_t shards_per_worker = 4;
+
+BatchPool::BatchPool(std::size_t envs, std::size_t horizontal, std::size_t vertical,
+                     std::uint64_t seed, std::size_t threads)
+  : _envs(envs) {
+  if (envs == 0)
+    throw std::invalid_argument("a pool needs at least one game");
+
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  auto shard_count = std::max<std::size_t>(1, std::min(envs, threads * shards_per_worker));
+  shard_envs = (envs + shard_count - 1) / shard_count;
+  shard_count = (envs + shard_envs - 1) / shard_envs;
+  threads = std::min(threads, shard_count);
+
+  for (std::size_t begin = 0; begin < envs; begin += shard_envs) {
+    auto count = std::min(shard_envs, envs - begin);
+    shards.push_back(
+      std::make_unique<BatchSim>(count, horizontal, vertical, seed, begin));
+  }
+
+  worker_count = threads;
+  queues = std::make_unique<Queue[]>(threads);
+  for (std::size_t worker = 0; worker < threads; worker++) {
+    queues[worker].begin = shard_count * worker / threads;
+    queues[worker].end = shard_count * (worker + 1) / threads;
+    queues[worker].next = queues[worker].end;
+  }
+
+  for (std::size_t worker = 0; worker < threads; worker++) {
+    workers.emplace_back([this, worker] { work(worker); });
+  }
+}
+
+BatchPool::~BatchPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  wake.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+// Claims and steps the next shard left in `queue`. The owner and thieves
+// claim shards the same way, so no shard is stepped twice.
+bool BatchPool::try_step(Queue &queue) {
+  auto shard = queue.next.fetch_add(1, std::memory_order_acquire);
+  if (shard >= queue.end) {
+    return false;
+  }
+
+  SNEK_TRACE_ZONE("shard step");
+
+  auto &sim = *shards[shard];
+  sim.reset_finished();
+  sim.step(actions + shard * shard_envs);
+
+  if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(mutex);
+    done.notify_all();
+  }
+
+  return true;
+}
+
+void BatchPool::work(std::size_t worker) {
+  std::uint64_t seen = 0;
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock, [&] { return stopping || generation != seen; });
+
+      if (stopping) {
+        return;
+      }
+
+      seen = generation;
+    }
+
+    while (try_step(queues[worker])) {
+    }
+
+    for (std::size_t i = 1; i < worker_count; i++) {
+      auto &victim = queues[(worker + i) % worker_count];
+
+      while (try_step(victim)) {
+      }
+    }
+  }
+}
+
+void BatchPool::step_async(const Direction *step_actions) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    actions = step_actions;
+    remaining.store(shards.size(), std::memory_order_relaxed);
+
+    for (std::size_t worker = 0; worker < worker_count; worker++) {
+      queues[worker].next.store(queues[worker].begin, std::memory_order_release);
+    }
+
+    generation++;
+  }
+
+  wake.notify_all();
+}
+
+void BatchPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [&] { return remaining.load(std::memory_order_acquire) == 0; });
+}
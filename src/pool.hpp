@@ -0,0 +1,92 @@
+#pragma once
+
+// Spreads a large batch of games over worker threads. The games are split
+// into shards, each a BatchSim of its own, and every worker starts on its own
+// contiguous run of shards before stealing from the others.
+
+#include "batch.hpp"
+#include "observation.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BatchPool {
+  struct alignas(64) Queue {
+    std::atomic<std::size_t> next{0};
+    std::size_t begin = 0, end = 0;
+  };
+
+  std::size_t _envs, shard_envs;
+
+  std::vector<std::unique_ptr<BatchSim>> shards;
+  std::unique_ptr<Queue[]> queues;
+  std::size_t worker_count;
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  std::uint64_t generation = 0;
+  bool stopping = false;
+
+  const Direction *actions = nullptr;
+  std::atomic<std::size_t> remaining{0};
+
+  bool try_step(Queue &queue);
+  void work(std::size_t worker);
+
+public:
+  // `threads` of zero uses one per core. Game `n` draws from stream `n` of
+  // `seed`, so it plays out the same however many threads there are. Throws
+  // std::invalid_argument for a pool of no games.
+  BatchPool(std::size_t envs, std::size_t horizontal, std::size_t vertical, std::uint64_t seed,
+            std::size_t threads = 0);
+  ~BatchPool();
+
+  BatchPool(const BatchPool &) = delete;
+  BatchPool &operator=(const BatchPool &) = delete;
+
+  std::size_t envs() const noexcept { return _envs; }
+
+  // Starts stepping every game with one action each and returns straight
+  // away. `actions` has to stay alive until wait() returns. Games that
+  // finished on the previous step are reset first.
+  void step_async(const Direction *actions);
+
+  // Blocks until the step started by step_async() is done. Only then may
+  // the games be read or another step started.
+  void wait();
+
+  void step(const Direction *actions) {
+    step_async(actions);
+    wait();
+  }
+
+  const BatchSim &shard_of(std::size_t env) const noexcept { return *shards[env / shard_envs]; }
+  std::size_t index_in_shard(std::size_t env) const noexcept { return env % shard_envs; }
+
+  MoveResult result(std::size_t env) const noexcept {
+    return shard_of(env).results()[index_in_shard(env)];
+  }
+
+  const BlockType *plane(std::size_t env) const noexcept {
+    return shard_of(env).plane(index_in_shard(env));
+  }
+
+  // Every game's observation in order, as BatchSim::write_observations().
+  // Like reading the games, only between steps.
+  template <typename T>
+  void write_observations(T *out, std::size_t crop = 0) const {
+    auto &first = *shards.front();
+    auto size = observation_size(first.horizontal(), first.vertical(), crop);
+
+    for (std::size_t shard = 0; shard < shards.size(); shard++) {
+      shards[shard]->write_observations(out + shard * shard_envs * size, crop);
+    }
+  }
+};
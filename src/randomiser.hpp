@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A PCG32 generator: 16 bytes of state, so every game can own one, and the
+// same seed and stream always give the same numbers.
+class Randomiser {
+  std::uint64_t state = 0;
+  std::uint64_t increment = 1;
+
+public:
+  // Everything needed to carry on the same sequence elsewhere.
+  struct State {
+    std::uint64_t state, increment;
+  };
+
+  explicit Randomiser(std::uint64_t seed, std::uint64_t stream = 0) noexcept
+    : state(0), increment((stream << 1u) | 1u) {
+    next();
+    state += seed;
+    next();
+  }
+
+  State save() const noexcept { return State{state, increment}; }
+
+  void restore(State saved) noexcept {
+    state = saved.state;
+    increment = saved.increment;
+  }
+
+  std::uint32_t next() noexcept {
+    auto old = state;
+    state = old * 6364136223846793005ULL + increment;
+
+    auto xorshifted = std::uint32_t(((old >> 18u) ^ old) >> 27u);
+    auto rot = std::uint32_t(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31u));
+  }
+
+  // A uniform draw from [0, bound) without modulo bias, using Lemire's
+  // multiply-and-reject method; it only divides on the rare rejection path.
+  std::uint32_t below(std::uint32_t bound) noexcept {
+    auto product = std::uint64_t(next()) * bound;
+    auto low = std::uint32_t(product);
+
+    if (low < bound) {
+      auto threshold = (0u - bound) % bound;
+
+      while (low < threshold) {
+        product = std::uint64_t(next()) * bound;
+        low = std::uint32_t(product);
+      }
+    }
+
+    return std::uint32_t(product >> 32u);
+  }
+
+  // A uniform draw from [min, max].
+  std::size_t gen(std::size_t min, std::size_t max) noexcept {
+    return min + below(std::uint32_t(max - min + 1));
+  }
+};
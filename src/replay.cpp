@@ -0,0 +1,351 @@
+#include "replay.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static constexpr char magic[4] = {'S', 'N', 'K', 'R'};
+static constexpr std::uint8_t version = 2;
+
+// Each turn is one varint of the ticks since the last one and the direction.
+static constexpr unsigned direction_bits = 3;
+
+// Segments after the head are stored as the two bit step from the one before.
+static std::uint8_t step_between(Position from, Position to) noexcept {
+  if (to.x < from.x)
+    return 0;
+  if (to.x > from.x)
+    return 1;
+  if (to.y < from.y)
+    return 2;
+  return 3;
+}
+
+static Direction step_direction(std::uint8_t step) noexcept { return Direction(step + 1); }
+
+ReplayWriter::ReplayWriter(const SnakeSim &sim, std::uint64_t seed,
+                           std::uint32_t keyframe_interval)
+  : horizontal(sim.board().horizontal()), vertical(sim.board().vertical()),
+    spawn_interval(sim.spawn_period()),
+    keyframe_interval(std::max<std::uint32_t>(1, keyframe_interval)), seed(seed) {
+  keyframe(sim);
+}
+
+void ReplayWriter::turn(std::uint32_t tick, Direction direction) {
+  put_varint(inputs,
+             std::uint64_t(tick - last_input_tick) << direction_bits | std::uint8_t(direction));
+
+  last_input_tick = tick;
+  input_count++;
+}
+
+void ReplayWriter::tick(const SnakeSim &sim, MoveResult result) {
+  ticks = sim.ticks();
+  this->result = result;
+
+  if (ticks % keyframe_interval == 0) {
+    keyframe(sim);
+  }
+}
+
+void ReplayWriter::keyframe(const SnakeSim &sim) {
+  keyframe_offsets.push_back(std::uint32_t(keyframes.size()));
+
+  auto &board = sim.board();
+  auto &snake = sim.snake();
+  auto rng = sim.rng_state();
+
+  put_varint(keyframes, sim.ticks());
+  put_varint(keyframes, inputs.size());
+  put_varint(keyframes, input_count);
+  put_varint(keyframes, last_input_tick);
+  put_u64(keyframes, rng.state);
+  put_u64(keyframes, rng.increment);
+  put_u8(keyframes, std::uint8_t(snake.direction()));
+
+  put_varint(keyframes, snake.len());
+  put_varint(keyframes, board.index(snake.head()));
+
+  std::uint8_t packed = 0;
+  for (std::size_t i = 1; i < snake.len(); i++) {
+    packed |= std::uint8_t(step_between(snake[i - 1], snake[i]) << (2 * ((i - 1) % 4)));
+
+    if ((i - 1) % 4 == 3 || i + 1 == snake.len()) {
+      put_u8(keyframes, packed);
+      packed = 0;
+    }
+  }
+
+  put_varint(keyframes, board.fruit_len());
+
+  // Ascending, so only the gap to the previous fruit has to be stored.
+  std::size_t last = 0;
+  for (std::size_t i = 0; i < board.len(); i++) {
+    if (board.is_fruit(i)) {
+      put_varint(keyframes, i - last);
+      put_u8(keyframes, board.colour(i));
+      last = i;
+    }
+  }
+}
+
+std::vector<std::uint8_t> ReplayWriter::serialise() const {
+  std::vector<std::uint8_t> out;
+  out.reserve(64 + inputs.size() + 4 * keyframe_offsets.size() + keyframes.size());
+
+  for (auto c : magic) {
+    put_u8(out, std::uint8_t(c));
+  }
+  put_u8(out, version);
+
+  put_varint(out, horizontal);
+  put_varint(out, vertical);
+  put_varint(out, spawn_interval);
+  put_varint(out, keyframe_interval);
+  put_u64(out, seed);
+  put_varint(out, ticks);
+  put_u8(out, std::uint8_t(result));
+
+  put_varint(out, input_count);
+  put_varint(out, inputs.size());
+  out.insert(out.end(), inputs.begin(), inputs.end());
+
+  put_varint(out, keyframe_offsets.size());
+  for (auto offset : keyframe_offsets) {
+    put_u32(out, offset);
+  }
+
+  put_varint(out, keyframes.size());
+  out.insert(out.end(), keyframes.begin(), keyframes.end());
+
+  return out;
+}
+
+bool ReplayWriter::save(const char *path) const {
+  auto bytes = serialise();
+
+  auto file = std::fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  auto written = std::fwrite(bytes.data(), 1, bytes.size(), file);
+  return std::fclose(file) == 0 && written == bytes.size();
+}
+
+Replay::Replay(Span<std::uint8_t> bytes) {
+  ByteReader reader(bytes.items, bytes.size());
+
+  if (std::memcmp(reader.skip(sizeof(magic)), magic, sizeof(magic)) != 0)
+    throw FormatError("not a replay");
+  if (reader.u8() != version)
+    throw FormatError("unsupported replay version");
+
+  _horizontal = reader.varint();
+  _vertical = reader.varint();
+  _spawn_interval = std::uint32_t(reader.varint());
+  _keyframe_interval = std::uint32_t(reader.varint());
+  _seed = reader.u64();
+  _ticks = std::uint32_t(reader.varint());
+  _result = MoveResult(reader.u8());
+
+  if (_horizontal == 0 || _vertical == 0 || _spawn_interval == 0 || _keyframe_interval == 0)
+    throw FormatError("replay header out of range");
+
+  _input_count = reader.varint();
+  auto input_len = reader.varint();
+  _inputs = Span<std::uint8_t>{reader.skip(input_len), input_len};
+
+  _keyframe_count = reader.varint();
+  if (_keyframe_count == 0 || _keyframe_count > reader.remaining() / 4)
+    throw FormatError("replay keyframe index out of range");
+
+  _keyframe_offsets = reader.skip(4 * _keyframe_count);
+
+  auto keyframe_len = reader.varint();
+  _keyframes = Span<std::uint8_t>{reader.skip(keyframe_len), keyframe_len};
+}
+
+Span<std::uint8_t> Replay::keyframe(std::size_t index) const {
+  auto offset = load_u32(_keyframe_offsets + 4 * index);
+  if (offset >= _keyframes.size())
+    throw FormatError("replay keyframe offset out of range");
+
+  return Span<std::uint8_t>{_keyframes.items + offset, _keyframes.size() - offset};
+}
+
+TurnReader::TurnReader(const Replay &replay, std::size_t offset, std::size_t read,
+                       std::uint32_t last_tick)
+  : reader(replay.inputs().items, replay.inputs().size()), _left(replay.input_count() - read),
+    last_tick(last_tick) {
+  if (read > replay.input_count())
+    throw FormatError("replay turn count out of range");
+
+  reader.seek(offset);
+}
+
+bool TurnReader::next(Turn &turn) {
+  if (_left == 0) {
+    return false;
+  }
+
+  auto packed = reader.varint();
+  auto direction = Direction(packed & ((1u << direction_bits) - 1));
+  if (direction > Direction::Down)
+    throw FormatError("replay turn out of range");
+
+  last_tick += std::uint32_t(packed >> direction_bits);
+  turn = Turn{last_tick, direction};
+  _left--;
+
+  return true;
+}
+
+ReplayPlayer::ReplayPlayer(const Replay &replay) : replay(&replay), turns(replay) { start(replay); }
+
+void ReplayPlayer::start(const Replay &replay) {
+  if (_sim && _sim->board().horizontal() == replay.horizontal() &&
+      _sim->board().vertical() == replay.vertical()) {
+    _sim->restart(replay.seed(), replay.spawn_interval());
+  } else {
+    _sim.emplace(replay.horizontal(), replay.vertical(), replay.seed(), replay.spawn_interval());
+  }
+
+  this->replay = &replay;
+  turns = TurnReader(replay);
+  has_pending = false;
+}
+
+MoveResult ReplayPlayer::step() {
+  while (has_pending || turns.next(pending)) {
+    has_pending = true;
+
+    if (pending.tick < _sim->ticks())
+      throw FormatError("replay turn out of order");
+    if (pending.tick > _sim->ticks())
+      break;
+
+    _sim->try_set_direction(pending.direction);
+    has_pending = false;
+  }
+
+  return _sim->try_tick();
+}
+
+void ReplayPlayer::seek(std::uint32_t tick) {
+  tick = std::min(tick, replay->ticks());
+
+  auto interval = replay->keyframe_interval();
+  auto nearest = std::min<std::size_t>(tick / interval, replay->keyframe_count() - 1);
+
+  // Playing on is cheaper than a keyframe if one would not get any closer.
+  if (tick < _sim->ticks() || _sim->ticks() < nearest * interval) {
+    auto bytes = replay->keyframe(nearest);
+    ByteReader reader(bytes.items, bytes.size());
+
+    auto ticks = std::uint32_t(reader.varint());
+    auto input_offset = reader.varint();
+    auto inputs_read = reader.varint();
+    auto input_tick = std::uint32_t(reader.varint());
+
+    Randomiser::State rng;
+    rng.state = reader.u64();
+    rng.increment = reader.u64();
+
+    auto direction = Direction(reader.u8());
+    auto &board = _sim->board();
+
+    auto snake_len = reader.varint();
+    auto head = reader.varint();
+    if (direction > Direction::Down || snake_len == 0 || snake_len > board.len() ||
+        head >= board.len())
+      throw FormatError("replay keyframe out of range");
+
+    segments.clear();
+    segments.push_back(Position{std::uint32_t(head % board.horizontal()),
+                                std::uint32_t(head / board.horizontal())});
+
+    std::uint8_t packed = 0;
+    for (std::size_t i = 1; i < snake_len; i++) {
+      if ((i - 1) % 4 == 0) {
+        packed = reader.u8();
+      }
+
+      auto next = segments.back() + to_pos(step_direction((packed >> (2 * ((i - 1) % 4))) & 3));
+      if (!board.contains(next))
+        throw FormatError("replay keyframe snake off the board");
+
+      segments.push_back(next);
+    }
+
+    auto fruit_count = reader.varint();
+    if (fruit_count > board.len())
+      throw FormatError("replay keyframe out of range");
+
+    fruits.clear();
+    colours.clear();
+
+    std::size_t index = 0;
+    for (std::size_t i = 0; i < fruit_count; i++) {
+      index += reader.varint();
+      if (index >= board.len())
+        throw FormatError("replay keyframe fruit off the board");
+
+      fruits.push_back(std::uint32_t(index));
+      colours.push_back(reader.u8());
+    }
+
+    if (snake_len + fruit_count > board.len())
+      throw FormatError("replay keyframe out of range");
+
+    // No block under both the snake and a fruit, or under the snake twice.
+    taken.assign(board.len(), false);
+    for (auto segment : segments) {
+      if (taken[board.index(segment)])
+        throw FormatError("replay keyframe blocks overlap");
+
+      taken[board.index(segment)] = true;
+    }
+
+    for (auto fruit : fruits) {
+      if (taken[fruit])
+        throw FormatError("replay keyframe blocks overlap");
+
+      taken[fruit] = true;
+    }
+
+    turns = TurnReader(*replay, input_offset, inputs_read, input_tick);
+    has_pending = false;
+
+    _sim->load(ticks, rng, Span<Position>{segments.data(), segments.size()}, direction,
+              Span<std::uint32_t>{fruits.data(), fruits.size()},
+              Span<std::uint8_t>{colours.data(), colours.size()});
+  }
+
+  while (_sim->ticks() < tick) {
+    step();
+  }
+}
+
+std::vector<std::uint8_t> read_file(const char *path) {
+  auto file = std::fopen(path, "rb");
+  if (file == nullptr)
+    throw FormatError(std::string("cannot open ") + path);
+
+  std::vector<std::uint8_t> bytes;
+  std::uint8_t chunk[1 << 16];
+
+  std::size_t read;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    bytes.insert(bytes.end(), chunk, chunk + read);
+  }
+
+  auto failed = std::ferror(file) != 0;
+  std::fclose(file);
+
+  if (failed)
+    throw FormatError(std::string("cannot read ") + path);
+
+  return bytes;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+// Compact, seekable recordings of a game. A replay stores the seed and the
+// turns made, each as a varint of (ticks since the last turn, direction), so
+// a few bytes cover a whole game. Every `keyframe_interval` ticks it also
+// stores a keyframe of the snake, fruits and generator, so playback can jump
+// to any tick by loading keyframe tick / interval and playing at most one
+// interval on. Fruit spawns by rank among the vacant blocks, so a keyframe
+// costs what the snake and fruits do rather than what the board does.
+//
+// Layout, all integers varints unless sized:
+//   "SNKR" u8:version
+//   horizontal vertical spawn_interval keyframe_interval u64:seed
+//   ticks u8:final_result
+//   input_count input_len input_bytes[input_len]
+//   keyframe_count u32:offsets[keyframe_count] keyframe_len keyframe_bytes[keyframe_len]
+
+#include "bytes.hpp"
+#include "sim.hpp"
+#include "storage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+static constexpr std::uint32_t default_keyframe_interval = 256;
+
+class ReplayWriter {
+  std::size_t horizontal, vertical;
+  std::uint32_t spawn_interval, keyframe_interval;
+  std::uint64_t seed;
+
+  std::vector<std::uint8_t> inputs;
+  std::size_t input_count = 0;
+  std::uint32_t last_input_tick = 0;
+
+  std::vector<std::uint8_t> keyframes;
+  std::vector<std::uint32_t> keyframe_offsets;
+
+  std::uint32_t ticks = 0;
+  MoveResult result = MoveResult::Ok;
+
+  void keyframe(const SnakeSim &sim);
+
+public:
+  // Starts recording `sim`, which must not have ticked yet and was built with `seed`.
+  ReplayWriter(const SnakeSim &sim, std::uint64_t seed,
+               std::uint32_t keyframe_interval = default_keyframe_interval);
+
+  // A turn that `sim` accepted before its tick number `tick` + 1.
+  void turn(std::uint32_t tick, Direction direction);
+
+  // Call after every tick with what try_tick() returned.
+  void tick(const SnakeSim &sim, MoveResult result);
+
+  std::vector<std::uint8_t> serialise() const;
+  bool save(const char *path) const;
+};
+
+// A parsed replay. It only points into the bytes it was parsed from, which
+// have to outlive it.
+class Replay {
+  std::size_t _horizontal = 0, _vertical = 0;
+  std::uint32_t _spawn_interval = 0, _keyframe_interval = 0;
+  std::uint64_t _seed = 0;
+  std::uint32_t _ticks = 0;
+  MoveResult _result = MoveResult::Ok;
+
+  std::size_t _input_count = 0;
+  Span<std::uint8_t> _inputs;
+
+  std::size_t _keyframe_count = 0;
+  const std::uint8_t *_keyframe_offsets = nullptr;
+  Span<std::uint8_t> _keyframes;
+
+public:
+  // Throws FormatError if `bytes` are not a replay.
+  explicit Replay(Span<std::uint8_t> bytes);
+
+  std::size_t horizontal() const noexcept { return _horizontal; }
+  std::size_t vertical() const noexcept { return _vertical; }
+  std::uint32_t spawn_interval() const noexcept { return _spawn_interval; }
+  std::uint32_t keyframe_interval() const noexcept { return _keyframe_interval; }
+  std::uint64_t seed() const noexcept { return _seed; }
+  std::uint32_t ticks() const noexcept { return _ticks; }
+  MoveResult result() const noexcept { return _result; }
+
+  std::size_t input_count() const noexcept { return _input_count; }
+  Span<std::uint8_t> inputs() const noexcept { return _inputs; }
+
+  std::size_t keyframe_count() const noexcept { return _keyframe_count; }
+  Span<std::uint8_t> keyframe(std::size_t index) const;
+};
+
+struct Turn {
+  std::uint32_t tick;
+  Direction direction;
+};
+
+// Decodes the turns of a replay in order, straight from its bytes.
+class TurnReader {
+  ByteReader reader;
+  std::size_t _left;
+  std::uint32_t last_tick;
+
+public:
+  explicit TurnReader(const Replay &replay) : TurnReader(replay, 0, 0, 0) {}
+
+  // Carries on after the first `read` turns, which took `offset` bytes and
+  // ended on tick `last_tick`.
+  TurnReader(const Replay &replay, std::size_t offset, std::size_t read, std::uint32_t last_tick);
+
+  std::size_t left() const noexcept { return _left; }
+
+  // Returns false once every turn has been read. Throws FormatError.
+  bool next(Turn &turn);
+};
+
+// Plays a replay back into a SnakeSim of its own.
+class ReplayPlayer {
+  const Replay *replay;
+  std::optional<SnakeSim> _sim;
+
+  TurnReader turns;
+  Turn pending;
+  bool has_pending = false;
+
+  // Scratch space for loading keyframes, kept to reuse its capacity.
+  std::vector<Position> segments;
+  std::vector<std::uint32_t> fruits;
+  std::vector<std::uint8_t> colours;
+  std::vector<bool> taken;
+
+public:
+  explicit ReplayPlayer(const Replay &replay);
+
+  // Starts on `replay` from its first tick, keeping the board if it is the
+  // same size as the last one, so a player can work through many games
+  // without allocating.
+  void start(const Replay &replay);
+
+  const SnakeSim &sim() const noexcept { return *_sim; }
+  SnakeSim &sim() noexcept { return *_sim; }
+
+  bool finished() const noexcept { return _sim->ticks() >= replay->ticks(); }
+
+  // Makes every turn due before the next tick, then ticks.
+  MoveResult step();
+
+  // Jumps to just after tick `tick` (0 being the start of the game).
+  void seek(std::uint32_t tick);
+};
+
+// Reads a whole file. Throws FormatError if it cannot be read.
+std::vector<std::uint8_t> read_file(const char *path);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "storage.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+// A fixed-capacity double-ended queue. Its items are one allocation made up
+// front, or an array inside the object when `N` is given.
+template <typename T, std::size_t N = dynamic_extent>
+class RingBuffer {
+  storage_t<T, N> items;
+  std::size_t first = 0;
+  std::size_t count = 0;
+
+  std::size_t wrap(std::size_t index) const noexcept {
+    return index >= capacity() ? index - capacity() : index;
+  }
+
+public:
+  explicit RingBuffer(std::size_t capacity = N,
+                      std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+    : items(Storage<T, N>::make(capacity, T(), memory)) {}
+
+  std::size_t capacity() const noexcept { return items.size(); }
+  std::size_t size() const noexcept { return count; }
+  bool empty() const noexcept { return count == 0; }
+
+  T &front() noexcept { return items[first]; }
+  const T &front() const noexcept { return items[first]; }
+  T &back() noexcept { return items[wrap(first + count - 1)]; }
+  const T &back() const noexcept { return items[wrap(first + count - 1)]; }
+
+  T &operator[](std::size_t index) noexcept { return items[wrap(first + index)]; }
+  const T &operator[](std::size_t index) const noexcept { return items[wrap(first + index)]; }
+
+  void push_front(T item) noexcept {
+    first = first == 0 ? capacity() - 1 : first - 1;
+    items[first] = std::move(item);
+    count++;
+  }
+
+  void pop_back() noexcept { count--; }
+
+  void clear() noexcept {
+    first = 0;
+    count = 0;
+  }
+
+  // The items front to back, as the run up to the end of the storage and the
+  // run that wrapped round to its start.
+  std::pair<Span<T>, Span<T>> runs() const noexcept {
+    auto head = std::min(count, capacity() - first);
+    return {Span<T>{items.data() + first, head}, Span<T>{items.data(), count - head}};
+  }
+
+  // Holds `len` items from the start of the storage, for the caller to fill
+  // front to back through the returned pointer.
+  T *assign(std::size_t len) noexcept {
+    first = 0;
+    count = len;
+    return items.data();
+  }
+};
@@ -0,0 +1,128 @@
+#include "shader_grid.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+static_assert(1 + fruit_colours == 4, "the shader's palette holds four colours");
+
+// Texture coordinates are in blocks, so `at` is which block a pixel lies in
+// and how far into it. Each block's top and left edges are drawn inside it,
+// the way the vertex grid draws a block's edges over its neighbours', and
+// the right and bottom edges of the board past its last blocks.
+static const char *fragment_source = R"(
+uniform sampler2D board;
+uniform vec2 size;
+uniform float line;
+uniform vec4 palette[4];
+
+void main() {
+  vec2 at = gl_TexCoord[0].xy;
+  vec2 block = min(floor(at), size - 1.0);
+  vec2 within = at - block;
+
+  vec4 texel = texture2D(board, (block + 0.5) / size);
+  vec4 colour = palette[int(texel.g * 255.0 + 0.5)];
+
+  bool edge = within.x < line || within.y < line || within.x >= 1.0 || within.y >= 1.0;
+  if (!edge && texel.r == 0.0) {
+    colour.a = 0.0;
+  }
+
+  gl_FragColor = colour;
+}
+)";
+
+void ShaderGrid::paint(std::size_t index) noexcept {
+  auto texel = &texels[index * 4];
+
+  texel[0] = std::uint8_t(board.type(index));
+  texel[1] = board.colour(index);
+  texel[2] = 0;
+  texel[3] = 0xFF;
+}
+
+ShaderGrid::ShaderGrid(Board &board, sf::Vector2f pos)
+  : board(board), origin(pos), texels(board.len() * 4) {
+  if (!available()) throw std::runtime_error("shaders are not available");
+
+  auto w = unsigned(board.horizontal()), h = unsigned(board.vertical());
+  if (std::max(w, h) > sf::Texture::getMaximumSize() || !texture.create(w, h))
+    throw std::runtime_error("the board does not fit in a texture");
+
+  if (!shader.loadFromMemory(fragment_source, sf::Shader::Fragment))
+    throw std::runtime_error("the grid shader did not compile");
+
+  for (std::size_t i = 0; i < board.len(); i++) {
+    paint(i);
+  }
+
+  sf::Glsl::Vec4 palette[1 + fruit_colours] = {
+    sf::Glsl::Vec4(to_colour(0)), sf::Glsl::Vec4(to_colour(1)), sf::Glsl::Vec4(to_colour(2)),
+    sf::Glsl::Vec4(to_colour(3))};
+
+  shader.setUniform("board", texture);
+  shader.setUniform("size", sf::Glsl::Vec2(float(w), float(h)));
+  shader.setUniform("line", line_len / block_len);
+  shader.setUniformArray("palette", palette, 1 + fruit_colours);
+
+  // The edges past the last blocks take the board out by a line's width.
+  auto blocks = sf::Vector2f(float(w) + line_len / block_len, float(h) + line_len / block_len);
+  auto size = blocks * block_len;
+
+  quad[0] = sf::Vertex(pos, sf::Vector2f(0.0f, 0.0f));
+  quad[1] = sf::Vertex(sf::Vector2f(pos.x + size.x, pos.y), sf::Vector2f(blocks.x, 0.0f));
+  quad[2] = sf::Vertex(pos + size, blocks);
+  quad[3] = sf::Vertex(sf::Vector2f(pos.x, pos.y + size.y), sf::Vector2f(0.0f, blocks.y));
+}
+
+void ShaderGrid::sync() {
+  last_upload = 0;
+
+  auto changed = board.changed();
+  for (auto index : changed) {
+    paint(index);
+  }
+
+  // Past a quarter of the board, one whole update beats many small ones.
+  if (stale || changed.size() * 4 >= board.len()) {
+    board.clear_changes();
+
+    if (board.len() != 0) {
+      texture.update(texels.data());
+      last_upload = texels.size();
+    }
+
+    stale = false;
+    return;
+  }
+
+  dirty.assign(changed.begin(), changed.end());
+  board.clear_changes();
+
+  std::sort(dirty.begin(), dirty.end());
+
+  // Neighbouring blocks in a row are neighbouring texels too, so runs of
+  // them go up in one update.
+  auto horizontal = board.horizontal();
+  for (std::size_t i = 0; i < dirty.size();) {
+    auto x = dirty[i] % horizontal, y = dirty[i] / horizontal;
+
+    std::size_t run = 1;
+    while (i + run < dirty.size() && dirty[i + run] == dirty[i] + run && x + run < horizontal) {
+      run++;
+    }
+
+    texture.update(&texels[dirty[i] * 4], unsigned(run), 1, unsigned(x), unsigned(y));
+    last_upload += run * 4;
+    i += run;
+  }
+}
+
+void ShaderGrid::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+  if (board.len() == 0) {
+    return;
+  }
+
+  states.shader = &shader;
+  target.draw(quad, states);
+}
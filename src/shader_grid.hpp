@@ -0,0 +1,53 @@
+#pragma once
+
+// Draws a board with one quad and a fragment shader, from a texture holding
+// a texel per block. Only the texels of blocks that changed go to the GPU,
+// so a frame costs the CPU the same on any size of board.
+
+#include "grid.hpp"
+#include "sim.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ShaderGrid : public sf::Drawable {
+  Board &board;
+  sf::Vector2f origin;
+
+  // RGBA per block: the block's type in red and its colour in green.
+  std::vector<std::uint8_t> texels;
+  sf::Texture texture;
+  sf::Shader shader;
+  sf::VertexArray quad{sf::Quads, 4};
+
+  // Set until the whole texture has gone up once.
+  bool stale = true;
+  std::vector<std::uint32_t> dirty;
+  std::size_t last_upload = 0;
+
+  void paint(std::size_t index) noexcept;
+
+public:
+  // Whether this machine can draw with shaders at all.
+  static bool available() { return sf::Shader::isAvailable(); }
+
+  // Lays the board out with its top left corner at `pos`. Throws
+  // std::runtime_error when there are no shaders, the board does not fit in
+  // a texture, or the shader does not compile; Grid draws any board.
+  ShaderGrid(Board &board, sf::Vector2f pos);
+
+  // Repaints and uploads the blocks the board reports as changed.
+  void sync();
+
+  // follow() for this grid's board.
+  sf::View camera(sf::Vector2f size, Position focus) const noexcept {
+    return follow(board, origin, size, focus);
+  }
+
+  // How many bytes the last sync() sent to the GPU.
+  std::size_t uploaded_bytes() const noexcept { return last_upload; }
+
+  void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+};
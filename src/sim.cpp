@@ -0,0 +1,21 @@
+#include "sim.hpp"
+
+#include <stdexcept>
+
+void throw_if_fatal(MoveResult result, Position attempted, std::size_t horizontal) {
+  switch (result) {
+  case MoveResult::HitWall:
+    if (attempted.x >= horizontal)
+      throw std::out_of_range("cannot move outside the grid horizontally");
+
+    throw std::out_of_range("cannot move outside the grid vertically");
+  case MoveResult::HitSelf:
+    throw CollisionException();
+  default:
+    break;
+  }
+}
+
+template class BasicBoard<>;
+template class BasicSnake<>;
+template class BasicSnakeSim<>;
@@ -0,0 +1,717 @@
+#pragma once
+
+// The game's rules and state, free of any rendering so it can be stepped
+// headless. Everything drawn on screen is a view over these types.
+//
+// Board, Snake and SnakeSim take their size at runtime. The Basic templates
+// they are made from can also fix it at compile time, e.g.
+// BasicSnakeSim<10, 10>, which folds indexing and bounds checks into
+// constants and keeps every array inside the object.
+//
+// Games sized at runtime take their arrays from a std::pmr::memory_resource,
+// the default one unless given another. Code that makes and drops games by
+// the million gives each worker thread a SlabPool (slab_pool.hpp) so it never
+// calls malloc once warm, and clones games with copy_from() rather than
+// making new ones.
+
+#include "bitboard.hpp"
+#include "metrics.hpp"
+#include "randomiser.hpp"
+#include "ring_buffer.hpp"
+#include "storage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <exception>
+#include <optional>
+#include <type_traits>
+
+enum class BlockType : std::uint8_t {
+  Vacant,
+  OccupiedSnake,
+  OccupiedFruit,
+};
+
+inline constexpr bool is_occupied(BlockType type) {
+  return type == BlockType::OccupiedFruit || type == BlockType::OccupiedSnake;
+}
+
+// Colours are indices into the renderer's palette. The snake and vacant
+// blocks use `snake_colour`; fruits pick one of the `fruit_colours` after it.
+static constexpr std::uint8_t snake_colour = 0;
+static constexpr std::uint8_t fruit_colours = 3;
+
+// One block as plain data: what occupies it and its colour. Boards keep
+// these packed into bit planes and a colour byte, and hand them out by value;
+// where a block is drawn is up to the renderer.
+struct Block {
+  BlockType type = BlockType::Vacant;
+  std::uint8_t colour = snake_colour;
+};
+
+static_assert(sizeof(Block) == 2, "a block is a type and a colour index");
+
+struct Position {
+  std::uint32_t x = 0, y = 0;
+};
+
+struct Offset {
+  int x = 0, y = 0;
+};
+
+inline Position operator+(Position lhs, Offset rhs) {
+  return Position{std::uint32_t(int(lhs.x) + rhs.x), std::uint32_t(int(lhs.y) + rhs.y)};
+}
+
+inline bool operator==(Position lhs, Position rhs) { return lhs.x == rhs.x && lhs.y == rhs.y; }
+inline bool operator!=(Position lhs, Position rhs) { return !(lhs == rhs); }
+
+enum class Direction : uint8_t {
+  None,
+  Left,
+  Right,
+  Up,
+  Down,
+};
+
+inline constexpr Offset to_pos(Direction direction) {
+  switch (direction) {
+  case Direction::Left:
+    return Offset{-1, 0};
+  case Direction::Right:
+    return Offset{1, 0};
+  case Direction::Up:
+    return Offset{0, -1};
+  case Direction::Down:
+    return Offset{0, 1};
+  default:
+    return Offset{0, 0};
+  }
+}
+
+// How a move went. Both Hit results end the game.
+enum class MoveResult : std::uint8_t {
+  Ok,
+  Ate,
+  HitWall,
+  HitSelf,
+};
+
+inline constexpr bool is_fatal(MoveResult result) {
+  return result == MoveResult::HitWall || result == MoveResult::HitSelf;
+}
+
+// Whether turning to `wanted` would send a snake heading `current` back
+// into itself.
+inline constexpr bool is_reversal(Direction current, Direction wanted) {
+  return (wanted == Direction::Left && current == Direction::Right) ||
+         (wanted == Direction::Right && current == Direction::Left) ||
+         (wanted == Direction::Up && current == Direction::Down) ||
+         (wanted == Direction::Down && current == Direction::Up);
+}
+
+// The snake moves every 0.25 seconds and a fruit spawns every 5, so a fruit
+// is due every this many moves.
+static constexpr std::uint32_t spawn_ticks = 20;
+
+struct MotorException : public std::exception {
+  const char *what() const noexcept override { return "cannot turn the opposite direction"; }
+};
+
+struct CollisionException : public std::exception {
+  const char *what() const noexcept override { return "collided with the snake's own body"; }
+};
+
+// Throws std::out_of_range or CollisionException for a fatal `result`, from
+// a move that tried to reach `attempted` on a board `horizontal` wide.
+void throw_if_fatal(MoveResult result, Position attempted, std::size_t horizontal);
+
+// What every block of the board holds, plus the bookkeeping that lets
+// spawning and rendering avoid scanning all of it. `H` and `V` are both
+// given, or both `dynamic_extent`.
+template <std::size_t H, std::size_t V>
+class BasicSnakeSim;
+
+template <std::size_t H = dynamic_extent, std::size_t V = dynamic_extent>
+class BasicBoard {
+  static_assert((H == dynamic_extent) == (V == dynamic_extent),
+                "either both or neither dimension is fixed");
+
+  static constexpr std::size_t N = H * V;
+
+  Extent<H> _horizontal;
+  Extent<V> _vertical;
+
+  // What occupies each block, one bit plane per kind of occupant. A block is
+  // never set in both.
+  BasicBitboard<N> snake, fruit;
+  storage_t<std::uint8_t, N> colours;
+
+  // How many blocks are vacant in each run of `run_len` blocks, so finding the
+  // nth vacant one skips whole runs rather than counting every word.
+  static constexpr std::size_t run_len = 4096;
+  static constexpr std::size_t Runs = (N + run_len - 1) / run_len;
+
+  storage_t<std::uint32_t, Runs> vacant_runs;
+  std::size_t vacant_count;
+
+  std::size_t run_count() const noexcept { return (len() + run_len - 1) / run_len; }
+
+  // Blocks whose type or colour changed since the last clear_changes(). A
+  // block is listed at most once, so the list never outgrows the board.
+  storage_t<std::uint32_t, N> changes;
+  std::size_t change_count = 0;
+  BasicBitboard<N> is_changed;
+
+  void mark_changed(std::size_t index) noexcept {
+    if (!is_changed.test(index)) {
+      is_changed.set(index);
+      changes[change_count++] = std::uint32_t(index);
+    }
+  }
+
+  // What every constructor comes down to. A fixed size ignores `horizontal`
+  // and `vertical`, so only this class and the game built on it pass them.
+  struct Sized {};
+
+  BasicBoard(Sized, std::size_t horizontal, std::size_t vertical,
+             std::pmr::memory_resource *memory);
+
+  friend class BasicSnakeSim<H, V>;
+
+public:
+  // Only a board sized at runtime takes a size.
+  template <std::size_t Fixed = H, typename = std::enable_if_t<Fixed == dynamic_extent>>
+  BasicBoard(std::size_t horizontal, std::size_t vertical,
+             std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+    : BasicBoard(Sized{}, horizontal, vertical, memory) {}
+
+  template <std::size_t Fixed = H, typename = std::enable_if_t<Fixed != dynamic_extent>>
+  BasicBoard() : BasicBoard(Sized{}, H, V, std::pmr::get_default_resource()) {}
+
+  std::size_t horizontal() const noexcept { return _horizontal.value(); }
+  std::size_t vertical() const noexcept { return _vertical.value(); }
+  std::size_t len() const noexcept { return horizontal() * vertical(); }
+
+  std::size_t index(Position pos) const noexcept { return pos.x + pos.y * horizontal(); }
+
+  Position position(std::size_t index) const noexcept {
+    return Position{std::uint32_t(index % horizontal()), std::uint32_t(index / horizontal())};
+  }
+
+  bool contains(Position pos) const noexcept {
+    return pos.x < horizontal() && pos.y < vertical();
+  }
+
+  BlockType type(std::size_t index) const noexcept {
+    if (snake.test(index)) {
+      return BlockType::OccupiedSnake;
+    }
+
+    return fruit.test(index) ? BlockType::OccupiedFruit : BlockType::Vacant;
+  }
+
+  BlockType type(Position pos) const noexcept { return type(index(pos)); }
+
+  Block block(std::size_t index) const noexcept { return Block{type(index), colours[index]}; }
+  Block block(Position pos) const noexcept { return block(index(pos)); }
+
+  bool is_snake(std::size_t index) const noexcept { return snake.test(index); }
+  bool is_snake(Position pos) const noexcept { return snake.test(index(pos)); }
+  bool is_fruit(std::size_t index) const noexcept { return fruit.test(index); }
+  bool is_fruit(Position pos) const noexcept { return fruit.test(index(pos)); }
+  bool is_occupied(std::size_t index) const noexcept { return is_snake(index) || is_fruit(index); }
+
+  const BasicBitboard<N> &snake_bits() const noexcept { return snake; }
+  const BasicBitboard<N> &fruit_bits() const noexcept { return fruit; }
+
+  std::size_t fruit_len() const noexcept { return fruit.count(); }
+
+  std::uint8_t colour(std::size_t index) const noexcept { return colours[index]; }
+
+  void set_type(std::size_t index, BlockType type) noexcept;
+  void set_type(Position pos, BlockType type) noexcept { set_type(index(pos), type); }
+  void set_colour(std::size_t index, std::uint8_t colour) noexcept;
+  void set_colour(Position pos, std::uint8_t colour) noexcept { set_colour(index(pos), colour); }
+
+  std::size_t vacant_len() const noexcept { return vacant_count; }
+
+  // The index of the `nth` vacant block in index order, for `nth` below
+  // vacant_len(). Fruit spawns by it, so where one lands depends only on which
+  // blocks are occupied, never on the order they were vacated in.
+  std::size_t nth_vacant(std::size_t nth) const noexcept;
+
+  Span<std::uint32_t> changed() const noexcept { return {changes.data(), change_count}; }
+  void clear_changes() noexcept;
+
+  // Makes every block vacant again, marking the occupied ones changed.
+  void clear() noexcept;
+
+  // Snapshots of everything above but the change list, which restoring marks
+  // every block in instead. Only a board of the same size can be restored.
+  std::size_t state_size() const noexcept;
+  std::uint8_t *save_state(std::uint8_t *out) const noexcept;
+  const std::uint8_t *restore_state(const std::uint8_t *in) noexcept;
+};
+
+template <std::size_t H = dynamic_extent, std::size_t V = dynamic_extent>
+class BasicSnake {
+  BasicBoard<H, V> &board;
+
+  // The index of every segment, head at the front and tail at the back. A
+  // snake can at most cover the whole board, so this never has to grow.
+  RingBuffer<std::uint32_t, H * V> body;
+
+  Direction _direction;
+
+public:
+  BasicSnake(BasicBoard<H, V> &board, Position initial,
+             std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+  // Takes on `other`'s body and direction, for the same size of board; the
+  // board's blocks are the board's to copy.
+  void copy_from(const BasicSnake &other) noexcept {
+    body = other.body;
+    _direction = other._direction;
+  }
+
+  // Moves the snake one block on. A fatal result leaves the snake and the
+  // board as they were.
+  MoveResult try_move() noexcept;
+
+  // try_move(), reporting a fatal result as std::out_of_range or
+  // CollisionException.
+  void move() {
+    auto attempted = head() + to_pos(_direction);
+
+    throw_if_fatal(try_move(), attempted, board.horizontal());
+  }
+
+  Position head() const noexcept { return board.position(body.front()); }
+  std::size_t len() const noexcept { return body.size(); }
+
+  // The `nth` segment counting from the head.
+  Position operator[](std::size_t nth) const noexcept { return board.position(body[nth]); }
+
+  Direction direction() const noexcept { return _direction; }
+
+  // Room is left for a snake covering the board, so a snapshot's size
+  // depends only on the board's.
+  std::size_t state_size() const noexcept {
+    return sizeof(std::size_t) + sizeof(Direction) + board.len() * sizeof(std::uint32_t);
+  }
+
+  std::uint8_t *save_state(std::uint8_t *out) const noexcept {
+    auto len = body.size();
+    auto runs = body.runs();
+
+    out = put_raw(out, &len, 1);
+    out = put_raw(out, &_direction, 1);
+    put_raw(put_raw(out, runs.first.items, runs.first.size()), runs.second.items,
+            runs.second.size());
+
+    return out + board.len() * sizeof(std::uint32_t);
+  }
+
+  const std::uint8_t *restore_state(const std::uint8_t *in) noexcept {
+    std::size_t len;
+
+    in = get_raw(in, &len, 1);
+    in = get_raw(in, &_direction, 1);
+    get_raw(in, body.assign(len), len);
+
+    return in + board.len() * sizeof(std::uint32_t);
+  }
+
+  // Returns false, and keeps the current direction, for a turn back on itself.
+  bool try_set_direction(Direction direct) noexcept {
+    if (is_reversal(_direction, direct)) {
+      return false;
+    }
+
+    _direction = direct;
+
+    return true;
+  }
+
+  // try_set_direction(), reporting a refused turn as MotorException.
+  void set_direction(Direction direct) {
+    if (!try_set_direction(direct))
+      throw MotorException();
+  }
+
+  // Replaces the snake with `segments` (head first) heading `direct`, on a
+  // board that has none of the old snake left on it.
+  void place(Span<Position> segments, Direction direct) noexcept {
+    body.clear();
+
+    for (std::size_t i = segments.size(); i-- > 0;) {
+      board.set_type(segments[i], BlockType::OccupiedSnake);
+      body.push_front(std::uint32_t(board.index(segments[i])));
+    }
+
+    _direction = direct;
+  }
+
+  // Takes the whole snake off the board, leaving it with no segments.
+  void remove() noexcept {
+    for (std::size_t i = 0; i < body.size(); i++) {
+      board.set_type(body[i], BlockType::Vacant);
+    }
+
+    body.clear();
+  }
+};
+
+// One game: a board, the snake on it and fruit spawning. Time is counted in
+// ticks rather than seconds and everything random comes from the game's own
+// generator, so a seed and the same turns replay the same game.
+template <std::size_t H = dynamic_extent, std::size_t V = dynamic_extent>
+class BasicSnakeSim {
+  BasicBoard<H, V> _board;
+  Randomiser rng;
+  BasicSnake<H, V> _snake;
+
+  std::uint32_t _ticks = 0;
+  std::uint32_t spawn_interval;
+
+  bool timing_spawns = false;
+
+  Position random_position() noexcept {
+    auto horizontal = rng.below(std::uint32_t(_board.horizontal()));
+    auto vertical = rng.below(std::uint32_t(_board.vertical()));
+
+    return Position{horizontal, vertical};
+  }
+
+  using Sized = typename BasicBoard<H, V>::Sized;
+
+  BasicSnakeSim(Sized, std::size_t horizontal, std::size_t vertical, std::uint64_t seed,
+                std::uint32_t spawn_interval, std::pmr::memory_resource *memory)
+    : _board(Sized{}, horizontal, vertical, memory), rng(seed),
+      _snake(_board, random_position(), memory),
+      spawn_interval(std::max<std::uint32_t>(1, spawn_interval)) {}
+
+public:
+  // Only a game sized at runtime takes a size; a fixed one is H by V.
+  template <std::size_t Fixed = H, typename = std::enable_if_t<Fixed == dynamic_extent>>
+  BasicSnakeSim(std::size_t horizontal, std::size_t vertical, std::uint64_t seed,
+                std::uint32_t spawn_interval = spawn_ticks,
+                std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+    : BasicSnakeSim(Sized{}, horizontal, vertical, seed, spawn_interval, memory) {}
+
+  template <std::size_t Fixed = H, typename = std::enable_if_t<Fixed != dynamic_extent>>
+  explicit BasicSnakeSim(std::uint64_t seed, std::uint32_t spawn_interval = spawn_ticks)
+    : BasicSnakeSim(Sized{}, H, V, seed, spawn_interval, std::pmr::get_default_resource()) {}
+
+  // The snake refers to the board it lives on.
+  BasicSnakeSim(const BasicSnakeSim &) = delete;
+  BasicSnakeSim &operator=(const BasicSnakeSim &) = delete;
+
+  // Becomes a copy of `other`, a game on the same size of board, reusing
+  // this game's arrays rather than allocating.
+  void copy_from(const BasicSnakeSim &other) noexcept {
+    _board = other._board;
+    rng = other.rng;
+    _snake.copy_from(other._snake);
+    _ticks = other._ticks;
+    spawn_interval = other.spawn_interval;
+  }
+
+  // Returns false when there is no room left for a fruit.
+  bool spawn_fruit() noexcept;
+
+  // Has every spawn_fruit() from now on time itself into
+  // metrics::Histogram::SpawnTime. Off unless asked for, so loops that spawn
+  // by the million pay nothing for it.
+  void time_spawns(bool on) noexcept { timing_spawns = on; }
+
+  MoveResult try_move() noexcept { return _snake.try_move(); }
+  void move() { _snake.move(); }
+
+  // One step of the game: a fruit if one is due, then a move. Only the move
+  // is undone by a fatal result: the tick is still counted, and a fruit due
+  // on it is still spawned, drawing from the generator, so the game ends
+  // one tick on, exactly as replays and lockstep peers see it end.
+  MoveResult try_tick() noexcept {
+    if (++_ticks % spawn_interval == 0) {
+      spawn_fruit();
+    }
+
+    return _snake.try_move();
+  }
+
+  // try_tick(), reporting a fatal result the way Snake::move() does.
+  void tick() {
+    auto attempted = _snake.head() + to_pos(_snake.direction());
+
+    throw_if_fatal(try_tick(), attempted, _board.horizontal());
+  }
+
+  // Starts over on the same board, exactly as a game built with `seed` would.
+  void restart(std::uint64_t seed, std::uint32_t spawn_interval = spawn_ticks) noexcept {
+    _board.clear();
+    rng = Randomiser(seed);
+
+    auto initial = random_position();
+    _snake.place(Span<Position>{&initial, 1}, Direction::None);
+
+    _ticks = 0;
+    this->spawn_interval = std::max<std::uint32_t>(1, spawn_interval);
+  }
+
+  std::uint32_t ticks() const noexcept { return _ticks; }
+  std::uint32_t spawn_period() const noexcept { return spawn_interval; }
+
+  // The whole game as state_size() bytes, for search and rollouts to branch
+  // from. Saving and restoring copy straight to and from `buffer`, and only
+  // a game on the same size of board can restore a snapshot. What is drawn
+  // picks up the change through the board's change list.
+  std::size_t state_size() const noexcept {
+    return sizeof(_ticks) + sizeof(spawn_interval) + sizeof(Randomiser::State) +
+           _board.state_size() + _snake.state_size();
+  }
+
+  void save_state(std::uint8_t *buffer) const noexcept {
+    auto saved = rng.save();
+
+    buffer = put_raw(buffer, &_ticks, 1);
+    buffer = put_raw(buffer, &spawn_interval, 1);
+    buffer = put_raw(buffer, &saved, 1);
+    _snake.save_state(_board.save_state(buffer));
+  }
+
+  void restore_state(const std::uint8_t *buffer) noexcept {
+    Randomiser::State saved;
+
+    buffer = get_raw(buffer, &_ticks, 1);
+    buffer = get_raw(buffer, &spawn_interval, 1);
+    buffer = get_raw(buffer, &saved, 1);
+    _snake.restore_state(_board.restore_state(buffer));
+
+    rng.restore(saved);
+  }
+  Randomiser::State rng_state() const noexcept { return rng.save(); }
+
+  // Puts the game in the middle of play: `ticks` in, with the generator at
+  // `saved`, the snake made of `segments` heading `direct`, a fruit of
+  // `colours[n]` at block `fruits[n]` and the rest vacant.
+  void load(std::uint32_t ticks, Randomiser::State saved, Span<Position> segments,
+            Direction direct, Span<std::uint32_t> fruits, Span<std::uint8_t> colours) noexcept {
+    _board.clear();
+    _snake.place(segments, direct);
+
+    for (std::size_t i = 0; i < fruits.size(); i++) {
+      _board.set_type(fruits[i], BlockType::OccupiedFruit);
+      _board.set_colour(fruits[i], colours[i]);
+    }
+
+    _ticks = ticks;
+    rng.restore(saved);
+  }
+
+  Direction direction() const noexcept { return _snake.direction(); }
+  bool try_set_direction(Direction direct) noexcept { return _snake.try_set_direction(direct); }
+  void set_direction(Direction direct) { _snake.set_direction(direct); }
+
+  BasicBoard<H, V> &board() noexcept { return _board; }
+  const BasicBoard<H, V> &board() const noexcept { return _board; }
+
+  const BasicSnake<H, V> &snake() const noexcept { return _snake; }
+};
+
+using Board = BasicBoard<>;
+using Snake = BasicSnake<>;
+using SnakeSim = BasicSnakeSim<>;
+
+template <std::size_t H, std::size_t V>
+BasicBoard<H, V>::BasicBoard(Sized, std::size_t horizontal, std::size_t vertical,
+                             std::pmr::memory_resource *memory)
+  : _horizontal(horizontal), _vertical(vertical), snake(len(), memory), fruit(len(), memory),
+    colours(Storage<std::uint8_t, N>::make(len(), snake_colour, memory)),
+    vacant_runs(Storage<std::uint32_t, Runs>::make(run_count(), run_len, memory)),
+    vacant_count(len()), changes(Storage<std::uint32_t, N>::make(len(), 0, memory)),
+    is_changed(len(), memory) {
+  if (len() % run_len != 0) {
+    vacant_runs[run_count() - 1] = std::uint32_t(len() % run_len);
+  }
+}
+
+template <std::size_t H, std::size_t V>
+std::size_t BasicBoard<H, V>::nth_vacant(std::size_t nth) const noexcept {
+  std::size_t run = 0;
+  while (nth >= vacant_runs[run]) {
+    nth -= vacant_runs[run++];
+  }
+
+  // Bits past len() read as vacant, but only after every real block of the
+  // last word, so `nth` never reaches them.
+  for (auto word = run * run_len / 64;; word++) {
+    auto free = ~(snake.words()[word] | fruit.words()[word]);
+    auto count = std::size_t(popcount(free));
+
+    if (nth < count) {
+      for (; nth > 0; nth--) {
+        free &= free - 1;
+      }
+
+      return word * 64 + std::size_t(__builtin_ctzll(free));
+    }
+
+    nth -= count;
+  }
+}
+
+template <std::size_t H, std::size_t V>
+void BasicBoard<H, V>::set_type(std::size_t index, BlockType type) noexcept {
+  if (is_occupied(index) != ::is_occupied(type)) {
+    if (::is_occupied(type)) {
+      vacant_runs[index / run_len]--;
+      vacant_count--;
+    } else {
+      vacant_runs[index / run_len]++;
+      vacant_count++;
+    }
+  }
+
+  snake.reset(index);
+  fruit.reset(index);
+
+  switch (type) {
+  case BlockType::Vacant:
+    break;
+  case BlockType::OccupiedSnake:
+    snake.set(index);
+    break;
+  case BlockType::OccupiedFruit:
+    fruit.set(index);
+    break;
+  }
+
+  mark_changed(index);
+}
+
+template <std::size_t H, std::size_t V>
+void BasicBoard<H, V>::set_colour(std::size_t index, std::uint8_t colour) noexcept {
+  colours[index] = colour;
+  mark_changed(index);
+}
+
+template <std::size_t H, std::size_t V>
+void BasicBoard<H, V>::clear_changes() noexcept {
+  for (std::size_t i = 0; i < change_count; i++) {
+    is_changed.reset(changes[i]);
+  }
+
+  change_count = 0;
+}
+
+template <std::size_t H, std::size_t V>
+void BasicBoard<H, V>::clear() noexcept {
+  for (std::size_t i = 0; i < len(); i++) {
+    if (is_occupied(i)) {
+      set_type(i, BlockType::Vacant);
+    }
+
+    if (colours[i] != snake_colour) {
+      set_colour(i, snake_colour);
+    }
+  }
+}
+
+template <std::size_t H, std::size_t V>
+std::size_t BasicBoard<H, V>::state_size() const noexcept {
+  return (snake.word_len() + fruit.word_len()) * sizeof(std::uint64_t) + len() +
+         run_count() * sizeof(std::uint32_t) + sizeof(vacant_count);
+}
+
+template <std::size_t H, std::size_t V>
+std::uint8_t *BasicBoard<H, V>::save_state(std::uint8_t *out) const noexcept {
+  out = put_raw(out, snake.words(), snake.word_len());
+  out = put_raw(out, fruit.words(), fruit.word_len());
+  out = put_raw(out, colours.data(), len());
+  out = put_raw(out, vacant_runs.data(), run_count());
+  return put_raw(out, &vacant_count, 1);
+}
+
+template <std::size_t H, std::size_t V>
+const std::uint8_t *BasicBoard<H, V>::restore_state(const std::uint8_t *in) noexcept {
+  in = get_raw(in, snake.words(), snake.word_len());
+  in = get_raw(in, fruit.words(), fruit.word_len());
+  in = get_raw(in, colours.data(), len());
+  in = get_raw(in, vacant_runs.data(), run_count());
+  in = get_raw(in, &vacant_count, 1);
+
+  for (std::size_t i = 0; i < len(); i++) {
+    mark_changed(i);
+  }
+
+  return in;
+}
+
+template <std::size_t H, std::size_t V>
+BasicSnake<H, V>::BasicSnake(BasicBoard<H, V> &board, Position initial,
+                             std::pmr::memory_resource *memory)
+  : board(board), body(board.len(), memory), _direction(Direction::None) {
+  board.set_type(initial, BlockType::OccupiedSnake);
+
+  body.push_front(std::uint32_t(board.index(initial)));
+}
+
+// Moving only ever touches the new head and, unless a fruit was eaten, the
+// old tail, so a tick costs the same however long the snake is.
+template <std::size_t H, std::size_t V>
+MoveResult BasicSnake<H, V>::try_move() noexcept {
+  auto new_pos = head() + to_pos(_direction);
+
+  if (!board.contains(new_pos)) {
+    return MoveResult::HitWall;
+  }
+
+  if (board.is_snake(new_pos)) {
+    return MoveResult::HitSelf;
+  }
+
+  bool was_occupied_by_fruit = board.is_fruit(new_pos);
+
+  if (!was_occupied_by_fruit) {
+    board.set_type(body.back(), BlockType::Vacant);
+    body.pop_back();
+  }
+
+  auto new_index = board.index(new_pos);
+
+  board.set_type(new_index, BlockType::OccupiedSnake);
+  body.push_front(std::uint32_t(new_index));
+
+  if (was_occupied_by_fruit) {
+    board.set_colour(new_index, snake_colour);
+  }
+
+  return was_occupied_by_fruit ? MoveResult::Ate : MoveResult::Ok;
+}
+
+template <std::size_t H, std::size_t V>
+bool BasicSnakeSim<H, V>::spawn_fruit() noexcept {
+  std::optional<metrics::Timer> timer;
+  if (timing_spawns) {
+    timer.emplace(metrics::Histogram::SpawnTime);
+  }
+
+  if (_board.vacant_len() == 0) {
+    return false;
+  }
+
+  auto index = _board.nth_vacant(rng.below(std::uint32_t(_board.vacant_len())));
+
+  _board.set_type(index, BlockType::OccupiedFruit);
+  _board.set_colour(index, std::uint8_t(1 + rng.below(fruit_colours)));
+
+  return true;
+}
+
+// The interactive game's runtime-sized variants are built once, in sim.cpp.
+extern template class BasicBoard<>;
+extern template class BasicSnake<>;
+extern template class BasicSnakeSim<>;
@@ -0,0 +1,57 @@
+#include "slab_pool.hpp"
+
+#include <algorithm>
+#include <new>
+
+SlabPool::SizeClass &SlabPool::class_of(std::size_t len, std::size_t alignment) {
+  // Blocks are at least big enough to link while free.
+  len = std::max(len, sizeof(FreeBlock));
+  alignment = std::max(alignment, alignof(FreeBlock));
+
+  for (auto &size_class : classes) {
+    if (size_class.len == len && size_class.alignment == alignment) {
+      return size_class;
+    }
+  }
+
+  classes.push_back(SizeClass{len, alignment});
+  return classes.back();
+}
+
+void *SlabPool::do_allocate(std::size_t len, std::size_t alignment) {
+  auto &size_class = class_of(len, alignment);
+
+  if (auto block = size_class.free) {
+    size_class.free = block->next;
+    return block;
+  }
+
+  auto block = upstream->allocate(size_class.len, size_class.alignment);
+  size_class.blocks++;
+
+  return block;
+}
+
+void SlabPool::do_deallocate(void *block, std::size_t len, std::size_t alignment) {
+  auto &size_class = class_of(len, alignment);
+
+  size_class.free = new (block) FreeBlock{size_class.free};
+}
+
+SlabPool::~SlabPool() {
+  for (auto &size_class : classes) {
+    while (auto block = size_class.free) {
+      size_class.free = block->next;
+      upstream->deallocate(block, size_class.len, size_class.alignment);
+    }
+  }
+}
+
+std::size_t SlabPool::blocks() const noexcept {
+  std::size_t total = 0;
+  for (auto &size_class : classes) {
+    total += size_class.blocks;
+  }
+
+  return total;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// A memory resource for games made and dropped by the million, as search
+// and batch workers do. It hands out each size of block it is asked for
+// from a free list of its own, so after the first game of a size, games of
+// that size come and go without calling malloc or free.
+//
+// A pool is for one thread, and has to outlive every game made from it.
+// Games that all go at once are served as well by a
+// std::pmr::monotonic_buffer_resource, which is a plain bump arena.
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+class SlabPool : public std::pmr::memory_resource {
+  // Every block of one size and alignment that is not in use, linked
+  // through its first bytes.
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  struct SizeClass {
+    std::size_t len, alignment;
+    FreeBlock *free = nullptr;
+    std::size_t blocks = 0;
+  };
+
+  std::pmr::memory_resource *upstream;
+
+  // A game asks for a handful of sizes, so a short list searched in order
+  // beats anything cleverer.
+  std::vector<SizeClass> classes;
+
+  SizeClass &class_of(std::size_t len, std::size_t alignment);
+
+  void *do_allocate(std::size_t len, std::size_t alignment) override;
+  void do_deallocate(void *block, std::size_t len, std::size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+    return this == &other;
+  }
+
+public:
+  explicit SlabPool(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource())
+    : upstream(upstream) {}
+
+  // Gives every free block back upstream.
+  ~SlabPool() override;
+
+  SlabPool(const SlabPool &) = delete;
+  SlabPool &operator=(const SlabPool &) = delete;
+
+  // How many blocks the pool has had from upstream, in use or free.
+  std::size_t blocks() const noexcept;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+/* The C ABI snek-arena loads controllers through. A policy is a shared
+ * library exporting the functions below; build it with, say,
+ *
+ *   cc -shared -fPIC -o my_policy.so my_policy.c
+ *
+ * One policy instance plays one game. The functions may be called from
+ * several threads at once, each with a different instance, so anything
+ * shared between instances is the policy's to guard. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNEK_POLICY_ABI 1
+
+/* Directions, numbered as the game numbers them. */
+enum {
+  SNEK_NONE = 0,
+  SNEK_LEFT = 1,
+  SNEK_RIGHT = 2,
+  SNEK_UP = 3,
+  SNEK_DOWN = 4,
+};
+
+/* The game as it stands before a tick. Blocks are numbered row by row,
+ * x + y * horizontal, and block n of a bit plane is bit n % 64 of word
+ * n / 64. Everything pointed to belongs to the arena and is only valid
+ * during the call it is passed to. */
+typedef struct snek_game {
+  uint32_t horizontal, vertical;
+  uint32_t ticks;
+
+  const uint64_t *snake;
+  const uint64_t *fruit;
+
+  uint32_t head, tail, length;
+  uint8_t direction;
+} snek_game;
+
+/* Returns SNEK_POLICY_ABI, so the arena can refuse a policy built against
+ * another version of this header. */
+uint32_t snek_policy_abi(void);
+
+/* A policy for one game on a board `horizontal` by `vertical`, with `seed`
+ * for anything it draws at random; NULL if it cannot play. */
+void *snek_policy_new(uint32_t horizontal, uint32_t vertical, uint64_t seed);
+
+/* The direction to take before the next tick. SNEK_NONE, or anything that
+ * is not a direction, keeps the current one; a turn back on itself is
+ * refused. A snake still without a direction after the call never moves,
+ * and the game ends there, recorded as idle. */
+uint8_t snek_policy_steer(void *policy, const snek_game *game);
+
+void snek_policy_free(void *policy);
+
+/* Optional: what to call the policy in results, instead of its path. */
+const char *snek_policy_name(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+#include "spectate.hpp"
+
+#include "bytes.hpp"
+
+#include <algorithm>
+
+enum class FrameKind : std::uint8_t {
+  Keyframe,
+  Delta,
+};
+
+// Nothing fills in the high bits, so shadow blocks holding this always
+// differ from the board's.
+static constexpr std::uint8_t unseen = 0xFF;
+
+// Frames longer than this are taken to be a corrupt stream, not a board.
+static constexpr std::uint64_t max_frame_len = std::uint64_t(1) << 28;
+
+static std::uint8_t block_of(const Board &board, std::size_t index) noexcept {
+  return std::uint8_t(std::uint8_t(board.type(index)) | board.colour(index) << 2);
+}
+
+SpectatorEncoder::SpectatorEncoder(const Board &board, std::uint32_t keyframe_interval)
+  : keyframe_interval(std::max<std::uint32_t>(1, keyframe_interval)),
+    shadow(board.len(), unseen) {}
+
+Frame SpectatorEncoder::finish() {
+  auto frame = std::make_shared<std::vector<std::uint8_t>>();
+
+  frame->reserve(body.size() + 5);
+  put_varint(*frame, body.size());
+  frame->insert(frame->end(), body.begin(), body.end());
+
+  return frame;
+}
+
+Frame SpectatorEncoder::encode(const Board &board, std::uint32_t tick) {
+  body.clear();
+
+  // A tick before the last is a new game, which spectators also start afresh.
+  if (recent.empty() || since_keyframe + 1 >= keyframe_interval || tick < last_tick) {
+    put_u8(body, std::uint8_t(FrameKind::Keyframe));
+    put_varint(body, tick);
+    put_varint(body, board.horizontal());
+    put_varint(body, board.vertical());
+
+    for (std::size_t i = 0; i < board.len();) {
+      auto block = block_of(board, i);
+
+      std::size_t run = 1;
+      while (i + run < board.len() && block_of(board, i + run) == block) {
+        run++;
+      }
+
+      std::fill_n(shadow.begin() + std::ptrdiff_t(i), run, block);
+      put_varint(body, std::uint64_t(run - 1) << 4 | block);
+      i += run;
+    }
+
+    recent.clear();
+    since_keyframe = 0;
+  } else {
+    changed.clear();
+    for (auto index : board.changed()) {
+      if (shadow[index] != block_of(board, index)) {
+        changed.push_back(index);
+      }
+    }
+
+    std::sort(changed.begin(), changed.end());
+
+    put_u8(body, std::uint8_t(FrameKind::Delta));
+    put_varint(body, tick - last_tick);
+    put_varint(body, changed.size());
+
+    std::size_t next = 0;
+    for (auto index : changed) {
+      auto block = block_of(board, index);
+
+      shadow[index] = block;
+      put_varint(body, std::uint64_t(index - next) << 4 | block);
+      next = index + 1;
+    }
+
+    since_keyframe++;
+  }
+
+  last_tick = tick;
+
+  auto frame = finish();
+  recent.push_back(frame);
+
+  return frame;
+}
+
+void SpectatorDecoder::set(std::size_t index, std::uint8_t block) {
+  auto type = BlockType(block & 3);
+  if (type > BlockType::OccupiedFruit || (block >> 2) > fruit_colours)
+    throw FormatError("no such block");
+
+  auto &board = *_board;
+  if (board.type(index) != type) {
+    board.set_type(index, type);
+  }
+
+  if (board.colour(index) != block >> 2) {
+    board.set_colour(index, std::uint8_t(block >> 2));
+  }
+}
+
+void SpectatorDecoder::apply(Span<std::uint8_t> frame) {
+  ByteReader in(frame.items, frame.size());
+
+  switch (FrameKind(in.u8())) {
+  case FrameKind::Keyframe: {
+    auto tick = in.varint();
+    auto horizontal = in.varint();
+    auto vertical = in.varint();
+
+    if (horizontal == 0 || vertical == 0 || horizontal * vertical > max_frame_len)
+      throw FormatError("keyframe board size out of range");
+
+    if (!_board || _board->horizontal() != horizontal || _board->vertical() != vertical) {
+      _board.reset();
+      _board.emplace(horizontal, vertical);
+      _boards++;
+    }
+
+    for (std::size_t i = 0; i < _board->len();) {
+      auto run = in.varint();
+      auto len = (run >> 4) + 1;
+
+      if (len > _board->len() - i)
+        throw FormatError("keyframe run past the end of the board");
+
+      for (auto end = i + len; i < end; i++) {
+        set(i, std::uint8_t(run & 0xF));
+      }
+    }
+
+    _tick = std::uint32_t(tick);
+    break;
+  }
+  case FrameKind::Delta: {
+    if (!_board)
+      throw FormatError("delta before the first keyframe");
+
+    _tick += std::uint32_t(in.varint());
+
+    auto count = in.varint();
+    std::size_t next = 0;
+
+    for (std::uint64_t i = 0; i < count; i++) {
+      auto change = in.varint();
+      auto index = next + (change >> 4);
+
+      if (index >= _board->len())
+        throw FormatError("delta past the end of the board");
+
+      set(index, std::uint8_t(change & 0xF));
+      next = index + 1;
+    }
+
+    break;
+  }
+  default:
+    throw FormatError("unknown frame kind");
+  }
+}
+
+std::size_t SpectatorDecoder::feed(const std::uint8_t *data, std::size_t len) {
+  partial.insert(partial.end(), data, data + len);
+
+  std::size_t frames = 0, pos = 0;
+
+  while (pos < partial.size()) {
+    // The length, unless it is still on its way.
+    std::uint64_t frame_len = 0;
+    std::size_t at = pos;
+    bool whole = false;
+
+    for (int shift = 0; at < partial.size() && shift < 64; shift += 7) {
+      auto byte = partial[at++];
+      frame_len |= std::uint64_t(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0) {
+        whole = true;
+        break;
+      }
+    }
+
+    if (!whole) {
+      if (at - pos >= 10)
+        throw FormatError("varint too long");
+
+      break;
+    }
+
+    if (frame_len > max_frame_len)
+      throw FormatError("frame too long");
+
+    if (partial.size() - at < frame_len) {
+      break;
+    }
+
+    apply(Span<std::uint8_t>{partial.data() + at, std::size_t(frame_len)});
+    pos = at + std::size_t(frame_len);
+    frames++;
+  }
+
+  partial.erase(partial.begin(), partial.begin() + std::ptrdiff_t(pos));
+
+  return frames;
+}
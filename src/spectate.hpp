@@ -0,0 +1,92 @@
+#pragma once
+
+// A stream of a live game for spectators. Each tick becomes one frame that
+// lists only the blocks that changed, typically a new head and a freed
+// tail, in a few bytes; every so often a keyframe gives the whole board,
+// run-length encoded, for spectators joining. A frame is encoded once and the
+// same buffer is shared by everyone it goes to.
+//
+// A frame is its length as a varint, then a kind byte:
+//   keyframe: varint tick, varint horizontal, varint vertical, then runs of
+//             varint((run - 1) << 4 | block) covering the board in order;
+//   delta:    varint ticks since the last frame, varint count, then for
+//             each changed block in order varint(gap << 4 | block), where
+//             `gap` is how many blocks were skipped since the last one.
+// A block is its BlockType in the low two bits and its colour above them.
+
+#include "sim.hpp"
+#include "storage.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+using Frame = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+class SpectatorEncoder {
+public:
+  static constexpr std::uint32_t default_keyframe_interval = 64;
+
+private:
+  std::uint32_t keyframe_interval;
+  std::uint32_t since_keyframe = 0;
+  std::uint32_t last_tick = 0;
+
+  // Every block as spectators last saw it.
+  std::vector<std::uint8_t> shadow;
+
+  // The latest keyframe and every delta since.
+  std::vector<Frame> recent;
+
+  // Per-frame scratch, kept to reuse its capacity.
+  std::vector<std::uint32_t> changed;
+  std::vector<std::uint8_t> body;
+
+  Frame finish();
+
+public:
+  explicit SpectatorEncoder(const Board &board,
+                            std::uint32_t keyframe_interval = default_keyframe_interval);
+
+  // The frame taking spectators to `board` as it is `tick` ticks in. Deltas
+  // come from the board's change list, which the encoder only reads: it may
+  // be cleared between frames, by drawing say, but a game with nothing else
+  // clearing it should do so after each frame, to keep it short. A `tick`
+  // before the last frame's starts a new game with a keyframe.
+  Frame encode(const Board &board, std::uint32_t tick);
+
+  // Everything a spectator joining now needs before the next frame.
+  const std::vector<Frame> &catch_up() const noexcept { return recent; }
+};
+
+// Rebuilds the game on the spectator's side, on a board of its own that
+// can be drawn like any other.
+class SpectatorDecoder {
+  std::optional<Board> _board;
+  std::uint32_t _tick = 0;
+  std::uint64_t _boards = 0;
+
+  // The start of a frame whose end has not arrived yet.
+  std::vector<std::uint8_t> partial;
+
+  void set(std::size_t index, std::uint8_t block);
+
+public:
+  // Applies one frame, without its length. Throws FormatError for anything
+  // malformed, and for a delta before any keyframe.
+  void apply(Span<std::uint8_t> frame);
+
+  // Takes in the next `len` bytes of a stream and applies every frame they
+  // complete. Returns how many that was.
+  std::size_t feed(const std::uint8_t *data, std::size_t len);
+
+  bool has_board() const noexcept { return _board.has_value(); }
+  Board &board() noexcept { return *_board; }
+  std::uint32_t tick() const noexcept { return _tick; }
+
+  // Goes up whenever a keyframe brings a board of a new size, and anything
+  // drawing the old one has to start over.
+  std::uint64_t boards() const noexcept { return _boards; }
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+// Sizes known at compile time live in a std::array; `dynamic_extent` ones in
+// a std::pmr::vector sized at construction, from whichever memory resource
+// the owner was given (see slab_pool.hpp), or the default one.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+
+static constexpr std::size_t dynamic_extent = 0;
+
+template <typename T, std::size_t N>
+struct Storage {
+  using type = std::array<T, N>;
+
+  static type make(std::size_t, const T &value, std::pmr::memory_resource * = nullptr) {
+    type items;
+    items.fill(value);
+    return items;
+  }
+};
+
+template <typename T>
+struct Storage<T, dynamic_extent> {
+  using type = std::pmr::vector<T>;
+
+  static type make(std::size_t len, const T &value,
+                   std::pmr::memory_resource *memory = std::pmr::get_default_resource()) {
+    return type(len, value, memory);
+  }
+};
+
+template <typename T, std::size_t N>
+using storage_t = typename Storage<T, N>::type;
+
+// A length that is a constant when `N` is given, and a stored value otherwise.
+template <std::size_t N>
+struct Extent {
+  explicit Extent(std::size_t) noexcept {}
+
+  static constexpr std::size_t value() noexcept { return N; }
+};
+
+template <>
+struct Extent<dynamic_extent> {
+  std::size_t len;
+
+  explicit Extent(std::size_t len) noexcept : len(len) {}
+
+  std::size_t value() const noexcept { return len; }
+};
+
+// A read-only view of `len` contiguous items.
+template <typename T>
+struct Span {
+  const T *items = nullptr;
+  std::size_t len = 0;
+
+  const T *begin() const noexcept { return items; }
+  const T *end() const noexcept { return items + len; }
+  std::size_t size() const noexcept { return len; }
+  bool empty() const noexcept { return len == 0; }
+  const T &operator[](std::size_t index) const noexcept { return items[index]; }
+};
+
+// Snapshots are the raw bytes of trivially copyable state laid end to end,
+// written and read back in the same order. Neither needs `out` or `in` to be
+// aligned.
+template <typename T>
+std::uint8_t *put_raw(std::uint8_t *out, const T *items, std::size_t len) noexcept {
+  std::memcpy(out, items, len * sizeof(T));
+  return out + len * sizeof(T);
+}
+
+template <typename T>
+const std::uint8_t *get_raw(const std::uint8_t *in, T *items, std::size_t len) noexcept {
+  std::memcpy(items, in, len * sizeof(T));
+  return in + len * sizeof(T);
+}
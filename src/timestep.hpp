@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Turns wall-clock time into a whole number of fixed-length ticks, carrying
+// the remainder over so the game runs at the same rate however often it is
+// polled.
+class FixedTimestep {
+public:
+  using clock = std::chrono::steady_clock;
+
+private:
+  clock::duration step;
+  clock::time_point last;
+  clock::duration accumulator{};
+
+  // After a long stall (a dragged window, a debugger) at most this many ticks
+  // are caught up at once; the rest of the backlog is dropped.
+  static constexpr std::uint32_t max_catch_up = 5;
+
+public:
+  explicit FixedTimestep(clock::duration step) : step(step), last(clock::now()) {}
+
+  clock::duration step_length() const noexcept { return step; }
+
+  // Forgets any time that passed since the last call, for when ticking resumes.
+  void reset() {
+    last = clock::now();
+    accumulator = clock::duration::zero();
+  }
+
+  // Takes in the time since the last call and returns how many ticks are due.
+  std::uint32_t advance() {
+    auto now = clock::now();
+    accumulator += now - last;
+    last = now;
+
+    auto due = std::uint32_t(accumulator / step);
+    accumulator -= due * step;
+
+    if (due > max_catch_up) {
+      due = max_catch_up;
+      accumulator = clock::duration::zero();
+    }
+
+    return due;
+  }
+
+  // When the tick fell due that is `left` from the end of those the last
+  // advance() returned: 1 for the latest, `due` for the earliest.
+  clock::time_point due_at(std::uint32_t left) const noexcept {
+    return last - accumulator - (left - 1) * step;
+  }
+
+  // How far into the next tick we are, from 0 to 1, for views that
+  // interpolate between ticks.
+  float alpha() const noexcept { return float(accumulator.count()) / float(step.count()); }
+
+  // How long until the next tick is due, as of the last advance().
+  clock::duration until_next() const noexcept {
+    return std::max(clock::duration::zero(), step - accumulator);
+  }
+};
@@ -0,0 +1,107 @@
+#include "trace.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+  static constexpr std::size_t capacity = std::size_t(1) << 16;
+
+  // Fields are relaxed atomics so dump() may read a buffer while its thread
+  // is still writing to it.
+  struct Event {
+    std::atomic<const char *> name{nullptr};
+    std::atomic<std::uint64_t> begin{0}, end{0};
+  };
+
+  struct Buffer {
+    std::uint32_t thread;
+    std::atomic<std::uint64_t> written{0};
+    std::unique_ptr<Event[]> events = std::make_unique<Event[]>(capacity);
+
+    explicit Buffer(std::uint32_t thread) : thread(thread) {}
+  };
+
+  // Buffers outlive their threads so a dump at exit still sees them.
+  static std::mutex registry_mutex;
+  static std::vector<std::unique_ptr<Buffer>> registry;
+
+  static const auto epoch = std::chrono::steady_clock::now();
+
+  static Buffer &local_buffer() {
+    thread_local Buffer *buffer = [] {
+      std::lock_guard<std::mutex> lock(registry_mutex);
+      registry.push_back(std::make_unique<Buffer>(std::uint32_t(registry.size() + 1)));
+      return registry.back().get();
+    }();
+
+    return *buffer;
+  }
+
+  std::uint64_t now_ns() noexcept {
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - epoch)
+                           .count());
+  }
+
+  void record(const char *name, std::uint64_t begin_ns, std::uint64_t end_ns) noexcept {
+    auto &buffer = local_buffer();
+    auto index = buffer.written.load(std::memory_order_relaxed);
+    auto &event = buffer.events[index % capacity];
+
+    // A seqlock's write side: a dump() that sees any of these stores also
+    // sees the `written` that says this slot is being reused.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin_ns, std::memory_order_relaxed);
+    event.end.store(end_ns, std::memory_order_relaxed);
+
+    buffer.written.store(index + 1, std::memory_order_release);
+  }
+
+  bool dump(const char *path) {
+    auto file = std::fopen(path, "w");
+    if (file == nullptr) {
+      return false;
+    }
+
+    std::fputs("{\"traceEvents\":[\n", file);
+
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    for (auto &buffer : registry) {
+      auto written = buffer->written.load(std::memory_order_acquire);
+      auto oldest = written > capacity ? written - capacity : 0;
+
+      for (auto index = oldest; index < written; index++) {
+        auto &event = buffer->events[index % capacity];
+        auto name = event.name.load(std::memory_order_relaxed);
+        auto begin = event.begin.load(std::memory_order_relaxed);
+        auto end = event.end.load(std::memory_order_relaxed);
+
+        // Skip anything the thread may have overwritten while we read it. The
+        // fence keeps the loads above from moving past the one below.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto now_written = buffer->written.load(std::memory_order_relaxed);
+        if (index + capacity <= now_written) {
+          continue;
+        }
+
+        std::fprintf(file,
+                     "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                     "\"dur\":%.3f}",
+                     first ? "" : ",\n", name, buffer->thread, double(begin) / 1e3,
+                     double(end - begin) / 1e3);
+        first = false;
+      }
+    }
+
+    std::fputs("\n]}\n", file);
+
+    return std::fclose(file) == 0;
+  }
+} // namespace trace
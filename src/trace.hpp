@@ -0,0 +1,43 @@
+#pragma once
+
+// Scoped trace zones written to a per-thread ring buffer and dumped as
+// Chrome trace JSON, which chrome://tracing and ui.perfetto.dev both open.
+//
+// Zones only exist when built with SNEK_TRACING (meson's `tracing` option);
+// otherwise SNEK_TRACE_ZONE compiles to nothing.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace trace {
+  std::uint64_t now_ns() noexcept;
+
+  // Records one finished zone on the calling thread. Never locks; the oldest
+  // events are overwritten once the thread's buffer is full.
+  void record(const char *name, std::uint64_t begin_ns, std::uint64_t end_ns) noexcept;
+
+  // Writes every thread's events to `path`. Returns false if it can't be written.
+  bool dump(const char *path);
+
+  class Zone {
+    const char *name;
+    std::uint64_t begin;
+
+  public:
+    explicit Zone(const char *name) noexcept : name(name), begin(now_ns()) {}
+    ~Zone() { record(name, begin, now_ns()); }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+  };
+} // namespace trace
+
+#define SNEK_TRACE_CONCAT_(a, b) a##b
+#define SNEK_TRACE_CONCAT(a, b) SNEK_TRACE_CONCAT_(a, b)
+
+#ifdef SNEK_TRACING
+#define SNEK_TRACE_ZONE(name) ::trace::Zone SNEK_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#else
+#define SNEK_TRACE_ZONE(name) static_cast<void>(0)
+#endif